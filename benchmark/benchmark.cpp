@@ -0,0 +1,437 @@
+// Compares returning and checking 'zpp::maybe' against 'std::expected',
+// exceptions, and error codes with out parameters, see run.sh.
+#include "maybe.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <limits>
+#include <string>
+#include <system_error>
+#include <type_traits>
+#include <vector>
+
+#if defined(__has_include)
+#if __has_include(<version>)
+#include <version>
+#endif
+#endif
+
+#if defined(__cpp_lib_expected)
+#include <expected>
+#endif
+
+namespace benchmark
+{
+enum class error : int
+{
+    success = 0,
+    failed = 1,
+};
+} // namespace benchmark
+
+template <>
+inline constexpr auto zpp::define_error_category<benchmark::error> =
+    zpp::make_error_category("benchmark",
+                             benchmark::error::success,
+                             {
+                                 {benchmark::error::failed,
+                                  "The operation failed."},
+                             });
+
+namespace benchmark
+{
+/**
+ * A 256 byte result.
+ */
+struct large
+{
+    std::uint64_t words[32];
+};
+
+/**
+ * The number of inputs in each pass.
+ */
+constexpr std::size_t inputs = 1024;
+
+/**
+ * The number of passes over the inputs in each measurement.
+ */
+constexpr std::size_t passes = 64;
+
+/**
+ * The depth of the propagation chains.
+ */
+constexpr int depth = 8;
+
+/**
+ * The inputs and whether each of them fails.
+ */
+struct input
+{
+    std::vector<int> values;
+    std::vector<char> failures;
+};
+
+/**
+ * Returns inputs of which about 'rate' percent fail, the failures are
+ * spread pseudo randomly so that they are not predicted.
+ */
+input make_input(unsigned rate)
+{
+    input result;
+    std::uint32_t state = 12345;
+    for (std::size_t index = 0; index != inputs; ++index) {
+        state = state * 1664525 + 1013904223;
+        result.values.push_back(int(state >> 8) & 0xffff);
+        result.failures.push_back((state >> 16) % 100 < rate);
+    }
+    return result;
+}
+
+template <typename Type>
+Type make(int value);
+
+template <>
+int make<int>(int value)
+{
+    return value;
+}
+
+template <>
+std::string make<std::string>(int value)
+{
+    return std::string(32, char('a' + value % 26));
+}
+
+template <>
+large make<large>(int value)
+{
+    large result{};
+    result.words[0] = std::uint64_t(value);
+    return result;
+}
+
+std::uint64_t digest(int value)
+{
+    return std::uint64_t(value);
+}
+
+std::uint64_t digest(const std::string & value)
+{
+    return value.size() + std::uint64_t(value[0]);
+}
+
+std::uint64_t digest(const large & value)
+{
+    return value.words[0];
+}
+
+/**
+ * Keeps the compiler from optimizing the value away.
+ */
+template <typename Type>
+void keep(const Type & value)
+{
+    asm volatile("" : : "r,m"(value) : "memory");
+}
+
+namespace with_maybe
+{
+template <typename Type>
+[[gnu::noinline]] zpp::maybe<Type> leaf(int value, bool fail)
+{
+    if (fail) {
+        return error::failed;
+    }
+    return make<Type>(value);
+}
+
+template <typename Type, int Depth>
+[[gnu::noinline]] zpp::maybe<Type> chain(int value, bool fail)
+{
+    if constexpr (!Depth) {
+        return leaf<Type>(value, fail);
+    } else {
+        ZPP_TRY(auto result, (chain<Type, Depth - 1>(value, fail)));
+        return result;
+    }
+}
+
+template <typename Type, int Depth>
+std::uint64_t pass(const input & input)
+{
+    std::uint64_t sum = 0;
+    for (std::size_t index = 0; index != inputs; ++index) {
+        auto result =
+            chain<Type, Depth>(input.values[index], input.failures[index]);
+        if (result) {
+            sum += digest(result.value());
+        } else {
+            sum += std::uint64_t(result.error().code());
+        }
+    }
+    return sum;
+}
+
+[[gnu::noinline]] std::string_view message(int code)
+{
+    return zpp::error(error(code)).message();
+}
+} // namespace with_maybe
+
+#if defined(__cpp_lib_expected)
+namespace with_expected
+{
+template <typename Type>
+[[gnu::noinline]] std::expected<Type, std::error_code> leaf(int value,
+                                                            bool fail)
+{
+    if (fail) {
+        return std::unexpected(
+            std::make_error_code(std::errc::invalid_argument));
+    }
+    return make<Type>(value);
+}
+
+template <typename Type, int Depth>
+[[gnu::noinline]] std::expected<Type, std::error_code> chain(int value,
+                                                             bool fail)
+{
+    if constexpr (!Depth) {
+        return leaf<Type>(value, fail);
+    } else {
+        auto result = chain<Type, Depth - 1>(value, fail);
+        if (!result) {
+            return std::unexpected(result.error());
+        }
+        return std::move(*result);
+    }
+}
+
+template <typename Type, int Depth>
+std::uint64_t pass(const input & input)
+{
+    std::uint64_t sum = 0;
+    for (std::size_t index = 0; index != inputs; ++index) {
+        auto result =
+            chain<Type, Depth>(input.values[index], input.failures[index]);
+        if (result) {
+            sum += digest(*result);
+        } else {
+            sum += std::uint64_t(result.error().value());
+        }
+    }
+    return sum;
+}
+} // namespace with_expected
+#endif
+
+namespace with_exceptions
+{
+struct failure
+{
+    int code;
+};
+
+template <typename Type>
+[[gnu::noinline]] Type leaf(int value, bool fail)
+{
+    if (fail) {
+        throw failure{1};
+    }
+    return make<Type>(value);
+}
+
+template <typename Type, int Depth>
+[[gnu::noinline]] Type chain(int value, bool fail)
+{
+    if constexpr (!Depth) {
+        return leaf<Type>(value, fail);
+    } else {
+        auto result = chain<Type, Depth - 1>(value, fail);
+        return result;
+    }
+}
+
+template <typename Type, int Depth>
+std::uint64_t pass(const input & input)
+{
+    std::uint64_t sum = 0;
+    for (std::size_t index = 0; index != inputs; ++index) {
+        try {
+            sum += digest(chain<Type, Depth>(input.values[index],
+                                             input.failures[index]));
+        } catch (const failure & failure) {
+            sum += std::uint64_t(failure.code);
+        }
+    }
+    return sum;
+}
+
+[[gnu::noinline]] std::string message(int code)
+{
+    return std::error_code(code, std::generic_category()).message();
+}
+} // namespace with_exceptions
+
+namespace with_error_code
+{
+template <typename Type>
+[[gnu::noinline]] int leaf(int value, bool fail, Type & output)
+{
+    if (fail) {
+        return 1;
+    }
+    output = make<Type>(value);
+    return 0;
+}
+
+template <typename Type, int Depth>
+[[gnu::noinline]] int chain(int value, bool fail, Type & output)
+{
+    if constexpr (!Depth) {
+        return leaf<Type>(value, fail, output);
+    } else {
+        if (auto code = chain<Type, Depth - 1>(value, fail, output)) {
+            return code;
+        }
+        return 0;
+    }
+}
+
+template <typename Type, int Depth>
+std::uint64_t pass(const input & input)
+{
+    std::uint64_t sum = 0;
+    for (std::size_t index = 0; index != inputs; ++index) {
+        Type output{};
+        if (auto code = chain<Type, Depth>(
+                input.values[index], input.failures[index], output)) {
+            sum += std::uint64_t(code);
+        } else {
+            sum += digest(output);
+        }
+    }
+    return sum;
+}
+} // namespace with_error_code
+
+/**
+ * Returns the best time per call of the given pass, in nanoseconds.
+ */
+template <typename Pass>
+double measure(Pass pass, const input & input)
+{
+    using clock = std::chrono::steady_clock;
+    auto best = std::numeric_limits<double>::max();
+    for (int run = 0; run != 5; ++run) {
+        auto start = clock::now();
+        for (std::size_t index = 0; index != passes; ++index) {
+            keep(pass(input));
+        }
+        std::chrono::duration<double, std::nano> elapsed =
+            clock::now() - start;
+        best = std::min(best, elapsed.count() / (passes * inputs));
+    }
+    return best;
+}
+
+/**
+ * Prints a row of the timing table for results of the given type,
+ * propagated through 'Depth' calls.
+ */
+template <typename Type, int Depth>
+void row(const char * name, unsigned rate)
+{
+    auto input = make_input(rate);
+    std::printf("%-24s %4u%%", name, rate);
+    std::printf(" %12.2f", measure(with_maybe::pass<Type, Depth>, input));
+#if defined(__cpp_lib_expected)
+    std::printf(" %14.2f",
+                measure(with_expected::pass<Type, Depth>, input));
+#else
+    std::printf(" %14s", "-");
+#endif
+    std::printf(" %12.2f",
+                measure(with_exceptions::pass<Type, Depth>, input));
+    std::printf(" %12.2f\n",
+                measure(with_error_code::pass<Type, Depth>, input));
+}
+
+/**
+ * Whether the type is returned in registers by the System V x86-64 and
+ * AArch64 calling conventions.
+ */
+template <typename Type>
+constexpr bool in_registers = sizeof(Type) <= 16 &&
+                              std::is_trivially_copy_constructible_v<Type> &&
+                              std::is_trivially_destructible_v<Type>;
+
+template <typename Type>
+void size(const char * name)
+{
+    std::printf("%-44s %6zu %10s\n",
+                name,
+                sizeof(Type),
+                in_registers<Type> ? "yes" : "no");
+}
+} // namespace benchmark
+
+int main()
+{
+    using namespace benchmark;
+
+    std::printf("%-44s %6s %10s\n", "type", "sizeof", "registers");
+    size<zpp::error>("zpp::error");
+    size<std::error_code>("std::error_code");
+    size<zpp::maybe<int>>("zpp::maybe<int>");
+    size<zpp::maybe<std::uint64_t>>("zpp::maybe<std::uint64_t>");
+    size<zpp::maybe<std::string>>("zpp::maybe<std::string>");
+    size<zpp::maybe<large>>("zpp::maybe<large>");
+#if defined(__cpp_lib_expected)
+    size<std::expected<int, std::error_code>>(
+        "std::expected<int, std::error_code>");
+    size<std::expected<std::string, std::error_code>>(
+        "std::expected<std::string, std::error_code>");
+    size<std::expected<large, std::error_code>>(
+        "std::expected<large, std::error_code>");
+#endif
+
+    std::printf("\nnanoseconds per call\n");
+    std::printf("%-24s %5s %12s %14s %12s %12s\n",
+                "case",
+                "fail",
+                "zpp::maybe",
+                "std::expected",
+                "exceptions",
+                "error code");
+    for (unsigned rate : {0u, 1u, 10u, 50u}) {
+        row<int, 0>("return int", rate);
+        row<std::string, 0>("return std::string", rate);
+        row<large, 0>("return 256 bytes", rate);
+        row<int, depth>("propagate int, depth 8", rate);
+    }
+
+    constexpr std::size_t lookups = passes * inputs;
+    using clock = std::chrono::steady_clock;
+    auto start = clock::now();
+    for (std::size_t index = 0; index != lookups; ++index) {
+        keep(with_maybe::message(1));
+    }
+    std::chrono::duration<double, std::nano> maybe_elapsed =
+        clock::now() - start;
+    start = clock::now();
+    for (std::size_t index = 0; index != lookups; ++index) {
+        keep(with_exceptions::message(EINVAL));
+    }
+    std::chrono::duration<double, std::nano> code_elapsed =
+        clock::now() - start;
+    std::printf("\nmessage() lookup, nanoseconds per call\n");
+    std::printf("%-24s %12.2f\n",
+                "zpp::error",
+                maybe_elapsed.count() / lookups);
+    std::printf("%-24s %12.2f\n",
+                "std::error_code",
+                code_elapsed.count() / lookups);
+}
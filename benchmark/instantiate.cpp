@@ -0,0 +1,111 @@
+// Instantiates 'zpp::maybe', or 'std::expected' when BENCHMARK_EXPECTED
+// is set, over BENCHMARK_TYPES distinct value types, so that run.sh can
+// compare their compile times.
+#include "maybe.h"
+#include <cstddef>
+#include <string>
+#include <utility>
+
+#if BENCHMARK_EXPECTED
+#include <expected>
+#endif
+
+#ifndef BENCHMARK_TYPES
+#define BENCHMARK_TYPES 300
+#endif
+
+namespace benchmark
+{
+enum class error : int
+{
+    success = 0,
+    failed = 1,
+};
+} // namespace benchmark
+
+template <>
+inline constexpr auto zpp::define_error_category<benchmark::error> =
+    zpp::make_error_category("benchmark",
+                             benchmark::error::success,
+                             {
+                                 {benchmark::error::failed,
+                                  "The operation failed."},
+                             });
+
+namespace benchmark
+{
+/**
+ * A distinct value type for each index, not trivially copyable so that
+ * the copy and move operations are instantiated as well.
+ */
+template <std::size_t Index>
+struct value
+{
+    int number;
+    std::string text;
+};
+
+#if BENCHMARK_EXPECTED
+template <typename Type>
+using result = std::expected<Type, error>;
+
+template <typename Type>
+result<Type> fail()
+{
+    return std::unexpected(error::failed);
+}
+#else
+template <typename Type>
+using result = zpp::maybe<Type>;
+
+template <typename Type>
+result<Type> fail()
+{
+    return error::failed;
+}
+#endif
+
+/**
+ * Returns a value of the given index, or an error for negative numbers.
+ */
+template <std::size_t Index>
+result<value<Index>> make(int number)
+{
+    if (number < 0) {
+        return fail<value<Index>>();
+    }
+    return value<Index>{number, std::string(Index % 32, 'x')};
+}
+
+/**
+ * Creates, propagates, copies and assigns results of the given index,
+ * using only the operations that both result types provide.
+ */
+template <std::size_t Index>
+result<int> use(int number)
+{
+    auto made = make<Index>(number);
+    if (!made) {
+        return fail<int>();
+    }
+    auto copy = made;
+    copy = make<Index>(-number);
+    auto moved = std::move(copy);
+    if (!moved) {
+        return made.value().number + int(made.value().text.size());
+    }
+    return moved.value().number;
+}
+
+template <std::size_t... Indices>
+int use_all(int number, std::index_sequence<Indices...>)
+{
+    return (use<Indices>(number).value_or(0) + ...);
+}
+} // namespace benchmark
+
+int main(int argc, char **)
+{
+    return benchmark::use_all(argc,
+                              std::make_index_sequence<BENCHMARK_TYPES>{});
+}
@@ -0,0 +1,92 @@
+#!/bin/sh
+# Builds benchmark.cpp at -O2 with each available compiler and prints the
+# sizes, timings and code size of each error handling approach, and the
+# time to compile instantiate.cpp over many types. Set CXX to a space
+# separated list of compilers to override, and TYPES to the number of
+# instantiated types.
+set -eu
+
+directory=$(cd "$(dirname "$0")" && pwd)
+compilers=${CXX:-"g++ clang++"}
+output=$(mktemp -d)
+types=${TYPES:-300}
+trap 'rm -rf "$output"' EXIT
+
+# Prints the current time in milliseconds.
+now() {
+    nanoseconds=$(date +%s%N)
+    case $nanoseconds in
+    *N) echo $(($(date +%s) * 1000)) ;;
+    *) echo $((nanoseconds / 1000000)) ;;
+    esac
+}
+
+# Prints the time in milliseconds to compile instantiate.cpp with the
+# given extra flags.
+compile_time() {
+    start=$(now)
+    "$compiler" -std=$standard -O0 -DZPP_MAYBE_COMPACT_ERROR=$compact \
+        -DBENCHMARK_TYPES=$types "$@" -I"$directory/.." \
+        -c "$directory/instantiate.cpp" -o "$output/instantiate.o"
+    echo $(($(now) - start))
+}
+
+for compiler in $compilers; do
+    if ! command -v "$compiler" > /dev/null 2>&1; then
+        continue
+    fi
+
+    # std::expected needs C++23, fall back to C++17 without it.
+    standard=
+    for candidate in c++23 c++2b c++17; do
+        if echo 'int main(){}' |
+            "$compiler" -std=$candidate -x c++ - -o "$output/probe" \
+                > /dev/null 2>&1; then
+            standard=$candidate
+            break
+        fi
+    done
+
+    for compact in 0 1; do
+        echo "== $compiler -std=$standard -O2" \
+            "ZPP_MAYBE_COMPACT_ERROR=$compact"
+        object="$output/benchmark.o"
+        "$compiler" -std=$standard -O2 -DZPP_MAYBE_COMPACT_ERROR=$compact \
+            -I"$directory/.." -c "$directory/benchmark.cpp" -o "$object"
+        "$compiler" "$object" -o "$output/benchmark"
+        "$output/benchmark"
+
+        echo
+        echo "code size in bytes, excluding exception tables"
+        nm -C -S -t d "$object" | awk '
+            $3 ~ /^[tTwW]$/ {
+                for (i = 4; i <= NF; ++i) {
+                    if (match($i, /benchmark::with_[a-z_]+::/)) {
+                        name = substr($i, RSTART + 11, RLENGTH - 13)
+                        size[name] += $2 + 0
+                        break
+                    }
+                }
+            }
+            END {
+                for (name in size) {
+                    printf "%-24s %12d\n", name, size[name]
+                }
+            }' | sort
+
+        echo
+        echo "compile time of $types instantiations at -O0 in milliseconds"
+        milliseconds=$(compile_time)
+        printf "%-24s %12d\n" maybe "$milliseconds"
+        if echo '#include <expected>
+                #ifndef __cpp_lib_expected
+                #error
+                #endif' |
+            "$compiler" -std=$standard -x c++ -fsyntax-only - \
+                > /dev/null 2>&1; then
+            milliseconds=$(compile_time -DBENCHMARK_EXPECTED=1)
+            printf "%-24s %12d\n" expected "$milliseconds"
+        fi
+        echo
+    done
+done
@@ -1,20 +1,279 @@
 #pragma once
+
+/**
+ * Define to 1 to encode errors in a single 64 bit word, where the
+ * category is stored as its stable identifier, which is mapped back to
+ * the category using the category registry, rather than as a pointer.
+ * This makes 'zpp::error' register sized.
+ */
+#ifndef ZPP_MAYBE_COMPACT_ERROR
+#define ZPP_MAYBE_COMPACT_ERROR 0
+#endif
+
+/**
+ * The capacity of the error category registry, a power of two.
+ */
+#ifndef ZPP_MAYBE_MAX_ERROR_CATEGORIES
+#define ZPP_MAYBE_MAX_ERROR_CATEGORIES 256
+#endif
+
+/**
+ * Define to 1 to record the errors propagated by 'ZPP_TRY' and
+ * 'zpp::maybe::trace()' into a thread local ring buffer, which can be
+ * read using 'zpp::this_thread_trace()'. When disabled, tracing compiles
+ * to nothing.
+ */
+#ifndef ZPP_MAYBE_TRACE
+#define ZPP_MAYBE_TRACE 0
+#endif
+
+/**
+ * The number of entries in the trace ring buffer, a power of two.
+ */
+#ifndef ZPP_MAYBE_TRACE_CAPACITY
+#define ZPP_MAYBE_TRACE_CAPACITY 64
+#endif
+
+/**
+ * Define to 1 to count the failing errors that are constructed, per
+ * category and code, see 'zpp::snapshot_error_counts()'. When disabled,
+ * constructing an error is not affected.
+ */
+#ifndef ZPP_MAYBE_COUNTERS
+#define ZPP_MAYBE_COUNTERS 0
+#endif
+
+/**
+ * The number of distinct category and code pairs that each thread
+ * counts, a power of two. Further pairs are counted as dropped.
+ */
+#ifndef ZPP_MAYBE_COUNTER_SLOTS
+#define ZPP_MAYBE_COUNTER_SLOTS 256
+#endif
+
+/**
+ * Define to 1 to capture the source location, and optionally the
+ * backtrace, of a sample of the counted failing errors, see
+ * 'zpp::snapshot_error_samples()'. Requires 'ZPP_MAYBE_COUNTERS'.
+ * When disabled, constructing an error is not affected.
+ */
+#ifndef ZPP_MAYBE_SAMPLING
+#define ZPP_MAYBE_SAMPLING 0
+#endif
+
+/**
+ * The default sampling period, one of every that many failing errors
+ * of a category and code is captured on each thread, see
+ * 'zpp::set_error_sample_period()'.
+ */
+#ifndef ZPP_MAYBE_SAMPLE_PERIOD
+#define ZPP_MAYBE_SAMPLE_PERIOD 1024
+#endif
+
+/**
+ * The number of samples that are kept, a power of two. Older samples
+ * are overwritten by newer ones.
+ */
+#ifndef ZPP_MAYBE_SAMPLE_CAPACITY
+#define ZPP_MAYBE_SAMPLE_CAPACITY 256
+#endif
+
+/**
+ * The number of backtrace frames captured with each sample, zero to not
+ * capture backtraces, which requires <execinfo.h> otherwise.
+ */
+#ifndef ZPP_MAYBE_SAMPLE_BACKTRACE
+#define ZPP_MAYBE_SAMPLE_BACKTRACE 0
+#endif
+
+/**
+ * Define to 1 to depend only on the freestanding parts of the standard
+ * library, together with <string_view> and <utility>, which is the
+ * default on freestanding implementations. Error counters are not
+ * available in this mode.
+ */
+#ifndef ZPP_MAYBE_FREESTANDING
+#if __STDC_HOSTED__
+#define ZPP_MAYBE_FREESTANDING 0
+#else
+#define ZPP_MAYBE_FREESTANDING 1
+#endif
+#endif
+
+#if ZPP_MAYBE_FREESTANDING && ZPP_MAYBE_COUNTERS
+#error "ZPP_MAYBE_COUNTERS requires a hosted implementation."
+#endif
+
+#if ZPP_MAYBE_SAMPLING && !ZPP_MAYBE_COUNTERS
+#error "ZPP_MAYBE_SAMPLING requires ZPP_MAYBE_COUNTERS."
+#endif
+
+#if ZPP_MAYBE_SAMPLING && ZPP_MAYBE_SAMPLE_BACKTRACE
+#if defined(__has_include)
+#if __has_include(<execinfo.h>)
+#include <execinfo.h>
+#define ZPP_MAYBE_HAS_EXECINFO 1
+#endif
+#endif
+#if !defined(ZPP_MAYBE_HAS_EXECINFO)
+#error "ZPP_MAYBE_SAMPLE_BACKTRACE requires <execinfo.h>."
+#endif
+#endif
+
+#include <atomic>
+
+#if __cplusplus >= 202002L && defined(__has_include)
+#if __has_include(<source_location>)
+#include <source_location>
+#endif
+#endif
+
+/**
+ * Branch prediction hints, where supported.
+ */
+#if __cplusplus >= 202002L
+#define ZPP_MAYBE_LIKELY [[likely]]
+#define ZPP_MAYBE_UNLIKELY [[unlikely]]
+#else
+#define ZPP_MAYBE_LIKELY
+#define ZPP_MAYBE_UNLIKELY
+#endif
+
+/**
+ * Marks functions that are called on error paths, so that the
+ * compiler moves their callers' branches out of the hot path.
+ */
+#if defined(__GNUC__) || defined(__clang__)
+#define ZPP_MAYBE_COLD [[gnu::cold]]
+#else
+#define ZPP_MAYBE_COLD
+#endif
+
+/**
+ * Expands to constexpr where C++20 allows it - virtual functions and
+ * destructors.
+ */
+#if __cplusplus >= 202002L
+#define ZPP_MAYBE_CONSTEXPR20 constexpr
+#else
+#define ZPP_MAYBE_CONSTEXPR20
+#endif
+
+/**
+ * Evaluates to true during constant evaluation, where supported,
+ * used to keep runtime instrumentation out of constant expressions.
+ */
+#if defined(__cpp_lib_is_constant_evaluated)
+#define ZPP_MAYBE_IS_CONSTANT_EVALUATED() std::is_constant_evaluated()
+#elif defined(__GNUC__) || defined(__clang__)
+#define ZPP_MAYBE_IS_CONSTANT_EVALUATED() __builtin_is_constant_evaluated()
+#else
+#define ZPP_MAYBE_IS_CONSTANT_EVALUATED() false
+#endif
+#include <cstddef>
+#include <cstdint>
+#if !ZPP_MAYBE_FREESTANDING
+#include <cstring>
+#endif
+#include <exception>
+#include <functional>
+#include <initializer_list>
+#if __cplusplus >= 202002L && !ZPP_MAYBE_FREESTANDING
+#include <memory>
+#endif
+#include <new>
 #include <string_view>
 #include <type_traits>
 #include <utility>
-#include <variant>
 
 namespace zpp
 {
+template <typename Type, typename Payload = void>
+class maybe;
+
+namespace maybe_detail
+{
+template <typename Payload>
+struct error_body;
+
+template <typename Type, typename Payload, bool TriviallyDestructible>
+struct storage;
+
+template <typename Type, typename Payload>
+struct operations;
+} // namespace maybe_detail
+
+namespace wire_detail
+{
+struct access;
+} // namespace wire_detail
+
+namespace error_detail
+{
+/**
+ * The type of 'define_error_category' for error code enumerations
+ * whose category is not defined through it.
+ */
+struct undefined_category
+{
+};
+
+class category_registry;
+} // namespace error_detail
+
+/**
+ * Defines the error category of an error code enumeration as a constant
+ * namespace scope object, by specializing this variable template.
+ * Since the category is constant initialized, creating an error
+ * stores the address of the category as an immediate, with no
+ * function call and no initialization guard check.
+ * Example:
+ * ~~~
+ * namespace my_namespace
+ * {
+ * enum class my_error : int
+ * {
+ *     success = 0,
+ *     something_bad = 1,
+ * };
+ * } // my_namespace
+ *
+ * template <>
+ * inline constexpr auto zpp::define_error_category<my_namespace::my_error> =
+ *     zpp::make_error_category("my_category",
+ *         my_namespace::my_error::success,
+ *         [](auto code) -> std::string_view {
+ *             switch (code) {
+ *                 case my_namespace::my_error::success:
+ *                     return zpp::error::no_error;
+ *                 case my_namespace::my_error::something_bad:
+ *                     return "Something bad happened.";
+ *                 default:
+ *                     return "Unknown error occurred.";
+ *             }
+ *         });
+ * ~~~
+ */
+template <typename ErrorCode>
+inline constexpr error_detail::undefined_category define_error_category{};
+
 /**
- * Returns the error category for a given error code enumeration type,
- * using an argument dependent lookup of a user implemented category
- * function.
+ * Returns the error category for a given error code enumeration type.
+ * If the category is defined using 'define_error_category' it is
+ * returned, otherwise, using an argument dependent lookup of a user
+ * implemented category function.
  */
 template <typename ErrorCode>
-decltype(auto) category()
+constexpr const auto & category()
 {
-    return category(ErrorCode{});
+    if constexpr (!std::is_same_v<
+                      std::remove_cv_t<
+                          decltype(define_error_category<ErrorCode>)>,
+                      error_detail::undefined_category>) {
+        return define_error_category<ErrorCode>;
+    } else {
+        return category(ErrorCode{});
+    }
 }
 
 /**
@@ -40,281 +299,4058 @@ public:
     /**
      * Returns true if success code, else false.
      */
-    bool success(int code) const
+    constexpr bool success(int code) const noexcept
     {
         return code == m_success_code;
     }
 
+    /**
+     * Returns the stable identifier of the category, which identifies
+     * the category across shared objects and processes. Unless given
+     * explicitly at construction, this is a hash of the category name,
+     * see 'zpp::make_error_category_id'.
+     */
+    constexpr std::uint32_t id() const noexcept
+    {
+        if (m_id) ZPP_MAYBE_LIKELY {
+            return m_id;
+        }
+        if (ZPP_MAYBE_IS_CONSTANT_EVALUATED()) {
+            return make_id(name());
+        }
+        if (auto id = m_hashed_id.load(std::memory_order_relaxed)) {
+            return id;
+        }
+        return hash_id();
+    }
+
 protected:
     /**
      * Creates an error category whose success code is 'success_code'.
+     * The identifier is a hash of the name, unless a non zero 'id' is
+     * given, which must be less than 2 to the power of 31.
+     */
+    constexpr error_category(int success_code, std::uint32_t id = 0) :
+        m_success_code(success_code),
+        m_id(id),
+        m_hashed_id(0),
+        m_registered(false)
+    {
+    }
+
+    /**
+     * Copies the error category, the copy hashes its name and is
+     * registered again.
      */
-    constexpr error_category(int success_code) :
-        m_success_code(success_code)
+    constexpr error_category(const error_category & other) noexcept :
+        m_success_code(other.m_success_code),
+        m_id(other.m_id),
+        m_hashed_id(0),
+        m_registered(false)
     {
     }
 
+    /**
+     * Disables assignment.
+     */
+    error_category & operator=(const error_category &) = delete;
+
     /**
      * Destroys the error category.
      */
     ~error_category() = default;
 
 private:
+    /**
+     * Allow 'make_error_category_id' to use the name hash.
+     */
+    friend constexpr std::uint32_t
+    make_error_category_id(std::string_view name) noexcept;
+
+    /**
+     * Allow the registry to mark the category as registered.
+     */
+    friend class error_detail::category_registry;
+
+    /**
+     * Returns the identifier of a category of the given name, the 32
+     * bit FNV-1a hash of the name reduced to 31 bits, and never zero.
+     */
+    static constexpr std::uint32_t make_id(std::string_view name) noexcept
+    {
+        std::uint32_t hash = 0x811c9dc5;
+        for (auto character : name) {
+            hash = (hash ^ std::uint8_t(character)) * 0x01000193;
+        }
+        hash >>= 1;
+        return hash ? hash : 1;
+    }
+
+    /**
+     * Hashes the name of a category that has no explicit identifier,
+     * and caches the identifier for later calls.
+     */
+    ZPP_MAYBE_COLD std::uint32_t hash_id() const noexcept
+    {
+        auto id = make_id(name());
+        m_hashed_id.store(id, std::memory_order_relaxed);
+        return id;
+    }
+
     /**
      * The success code.
      */
     int m_success_code{};
+
+    /**
+     * The identifier, zero to use the hash of the name.
+     */
+    std::uint32_t m_id{};
+
+    /**
+     * The hash of the name once computed, if there is no identifier.
+     */
+    mutable std::atomic<std::uint32_t> m_hashed_id;
+
+    /**
+     * Whether the registration of the category was attempted, so that
+     * errors of it register it once.
+     */
+    mutable std::atomic<bool> m_registered;
 };
 
 /**
- * Creates an error category, whose name and success
+ * Returns the identifier of an error category of the given name, used
+ * by default as the stable identifier of categories.
+ */
+constexpr std::uint32_t make_error_category_id(std::string_view name) noexcept
+{
+    return error_category::make_id(name);
+}
+
+/**
+ * Creates an error category, whose name, identifier and success
  * code are specified, as well as a message translation
  * logic that returns the error message for every error code.
  * Note: message translation must not throw.
  */
 template <typename ErrorCode, typename Messages>
 constexpr auto make_error_category(std::string_view name,
+                                   std::uint32_t id,
                                    ErrorCode success_code,
                                    Messages && messages)
 {
     // Create a category with the name and messages.
-    class category : public error_category,
-                     private std::remove_reference_t<Messages>
+    class category final : public error_category,
+                           private std::remove_reference_t<Messages>
     {
     public:
         constexpr category(std::string_view name,
+                           std::uint32_t id,
                            ErrorCode success_code,
                            Messages && messages) :
             error_category(
-                std::underlying_type_t<ErrorCode>(success_code)),
+                std::underlying_type_t<ErrorCode>(success_code), id),
             std::remove_reference_t<Messages>(
                 std::forward<Messages>(messages)),
             m_name(name)
         {
         }
 
-        std::string_view name() const noexcept override
+        ZPP_MAYBE_CONSTEXPR20 std::string_view name() const noexcept override
         {
             return m_name;
         }
 
-        std::string_view message(int code) const noexcept override
+        ZPP_MAYBE_CONSTEXPR20 std::string_view
+        message(int code) const noexcept override
         {
             return this->operator()(ErrorCode{code});
         }
 
     private:
         std::string_view m_name;
-    } category(name, success_code, std::forward<Messages>(messages));
+    } category(name, id, success_code, std::forward<Messages>(messages));
 
     // Return the category.
     return category;
 }
 
 /**
- * This namespace is a workaround allowing us to delay the introduction of
- * 'error' in this scope to avoid conflict with language rules in class
- * 'maybe'.
+ * Creates an error category, whose name and success
+ * code are specified, as well as a message translation
+ * logic that returns the error message for every error code.
+ * The identifier of the category is the hash of its name.
+ * Note: message translation must not throw.
+ */
+template <typename ErrorCode, typename Messages>
+constexpr auto make_error_category(std::string_view name,
+                                   ErrorCode success_code,
+                                   Messages && messages)
+{
+    return make_error_category(name,
+                               make_error_category_id(name),
+                               success_code,
+                               std::forward<Messages>(messages));
+}
+
+/**
+ * An error code and its message, used to build an error category
+ * from a message table.
  */
+template <typename ErrorCode>
+struct error_message
+{
+    /**
+     * The error code.
+     */
+    ErrorCode code;
+
+    /**
+     * The error message.
+     */
+    std::string_view message;
+};
+
 namespace error_detail
 {
 /**
- * Represents an error to be initialized from an error code
- * enumeration.
- * The error code enumeration must have 'int' as underlying type.
- * Defining an error code enum and a category for it goes as follows.
+ * Prevents template argument deduction of the given type.
+ */
+template <typename Type>
+struct identity
+{
+    using type = Type;
+};
+
+/**
+ * The message of codes missing from an error category message table.
+ */
+inline constexpr std::string_view unknown_error = "Unknown error occurred.";
+
+/**
+ * Called for a code that appears twice in an error category message
+ * table, it is not constexpr so that the constant evaluation of the
+ * category fails.
+ */
+inline void duplicate_code_in_message_table() noexcept
+{
+}
+} // namespace error_detail
+
+/**
+ * Creates an error category, whose name, identifier and success
+ * code are specified, along with a table of error messages.
+ * The table is sorted at compile time, when the codes are contiguous
+ * the message lookup is a bounds checked indexed load, otherwise it
+ * is a binary search. Codes that are missing from the table are
+ * translated to a generic unknown error message. Codes must be unique,
+ * a duplicate code fails the constant evaluation of the category.
  * Example:
  * ~~~
- * namespace my_namespace
- * {
- * enum class my_error : int
- * {
- *     success = 0,
- *     something_bad = 1,
- *     something_really_bad = 2,
- * };
- *
- * inline const zpp::error_category & category(my_error)
- * {
- *     constexpr static auto error_category =
- *         zpp::make_error_category("my_category", my_error::success,
- *             [](auto code) -> std::string_view {
- *                 switch (code) {
- *                     case my_error::success:
- *                         return zpp::error::no_error;
- *                     case my_code:something_bad:
- *                         return "Something bad happened.";
- *                     case my_error::something_really_bad:
- *                         return "Something really bad happened.";
- *                     default:
- *                         return "Unknown error occurred.";
- *                 }
- *             }
- *         );
- *     return error_category;
- * }
- * } // my_namespace
+ * template <>
+ * inline constexpr auto zpp::define_error_category<my_error> =
+ *     zpp::make_error_category("my_category", my_error::success, {
+ *         {my_error::success, zpp::error::no_error},
+ *         {my_error::something_bad, "Something bad happened."},
+ *         {my_error::something_really_bad, "Something really bad happened."},
+ *     });
  * ~~~
  */
-class error
+template <typename ErrorCode, std::size_t Size>
+constexpr auto make_error_category(
+    std::string_view name,
+    std::uint32_t id,
+    ErrorCode success_code,
+    const error_message<typename error_detail::identity<ErrorCode>::type> (
+        &messages)[Size])
+{
+    // Create a category with the name and the sorted message table.
+    class category final : public error_category
+    {
+    public:
+        constexpr category(std::string_view name,
+                           std::uint32_t id,
+                           ErrorCode success_code,
+                           const error_message<ErrorCode> (&messages)[Size]) :
+            error_category(
+                std::underlying_type_t<ErrorCode>(success_code), id),
+            m_name(name)
+        {
+            // Insertion sort the table by code.
+            for (std::size_t i = 0; i < Size; ++i) {
+                auto code =
+                    std::underlying_type_t<ErrorCode>(messages[i].code);
+                auto message = messages[i].message;
+                auto position = i;
+                for (; position > 0 && m_codes[position - 1] > code;
+                     --position) {
+                    m_codes[position] = m_codes[position - 1];
+                    m_messages[position] = m_messages[position - 1];
+                }
+                m_codes[position] = code;
+                m_messages[position] = message;
+            }
+
+            // The table is dense if the codes are contiguous and unique,
+            // duplicate codes are rejected during constant evaluation.
+            m_dense = (std::int64_t(m_codes[Size - 1]) - m_codes[0] + 1 ==
+                       std::int64_t(Size));
+            for (std::size_t i = 1; i < Size; ++i) {
+                if (m_codes[i - 1] == m_codes[i]) {
+                    error_detail::duplicate_code_in_message_table();
+                    m_dense = false;
+                }
+            }
+        }
+
+        ZPP_MAYBE_CONSTEXPR20 std::string_view name() const noexcept override
+        {
+            return m_name;
+        }
+
+        ZPP_MAYBE_CONSTEXPR20 std::string_view
+        message(int code) const noexcept override
+        {
+            if (m_dense) {
+                auto index = std::uint64_t(std::int64_t(code) - m_codes[0]);
+                if (index < Size) {
+                    return m_messages[index];
+                }
+                return error_detail::unknown_error;
+            }
+
+            std::size_t first = 0;
+            std::size_t last = Size;
+            while (first < last) {
+                auto middle = first + (last - first) / 2;
+                if (m_codes[middle] < code) {
+                    first = middle + 1;
+                } else {
+                    last = middle;
+                }
+            }
+
+            if (first < Size && m_codes[first] == code) {
+                return m_messages[first];
+            }
+            return error_detail::unknown_error;
+        }
+
+    private:
+        std::string_view m_name;
+        int m_codes[Size]{};
+        std::string_view m_messages[Size]{};
+        bool m_dense{};
+    } category(name, id, success_code, messages);
+
+    // Return the category.
+    return category;
+}
+
+/**
+ * Creates an error category, whose name and success
+ * code are specified, along with a table of error messages, as above.
+ * The identifier of the category is the hash of its name.
+ */
+template <typename ErrorCode, std::size_t Size>
+constexpr auto make_error_category(
+    std::string_view name,
+    ErrorCode success_code,
+    const error_message<typename error_detail::identity<ErrorCode>::type> (
+        &messages)[Size])
+{
+    return make_error_category(
+        name, make_error_category_id(name), success_code, messages);
+}
+
+#if defined(__cpp_lib_source_location)
+/**
+ * The source location recorded by error traces.
+ */
+using trace_location = std::source_location;
+#else
+/**
+ * The source location recorded by error traces, a subset of
+ * 'std::source_location' for standards that do not have it.
+ */
+class trace_location
 {
 public:
     /**
-     * Disables default construction.
+     * Returns the location of the caller.
      */
-    error() = delete;
+    static constexpr trace_location
+    current(const char * file = __builtin_FILE(),
+            const char * function = __builtin_FUNCTION(),
+            std::uint_least32_t line = __builtin_LINE()) noexcept
+    {
+        trace_location location;
+        location.m_file = file;
+        location.m_function = function;
+        location.m_line = line;
+        return location;
+    }
 
     /**
-     * Constructs an error from an error code enumeration, the
-     * category is looked by using argument dependent lookup on a
-     * function named 'category' that receives the error code
-     * enumeration value.
+     * Returns the file name.
      */
-    template <typename ErrorCode>
-    error(ErrorCode error_code) :
-        m_category(std::addressof(zpp::category<ErrorCode>())),
-        m_code(std::underlying_type_t<ErrorCode>(error_code))
+    constexpr const char * file_name() const noexcept
     {
+        return m_file;
     }
 
     /**
-     * Constructs an error from an error code enumeration, the
+     * Returns the function name.
+     */
+    constexpr const char * function_name() const noexcept
+    {
+        return m_function;
+    }
+
+    /**
+     * Returns the line number.
+     */
+    constexpr std::uint_least32_t line() const noexcept
+    {
+        return m_line;
+    }
+
+    /**
+     * Returns the column number, which is not known.
+     */
+    constexpr std::uint_least32_t column() const noexcept
+    {
+        return 0;
+    }
+
+private:
+    /**
+     * The file name.
+     */
+    const char * m_file = "";
+
+    /**
+     * The function name.
+     */
+    const char * m_function = "";
+
+    /**
+     * The line number.
+     */
+    std::uint_least32_t m_line{};
+};
+#endif
+
+/**
+ * Declares and passes the source location of the error construction
+ * that is captured when sampling failing errors, expands to nothing
+ * otherwise, so that constructing an error is not affected.
+ */
+#if ZPP_MAYBE_SAMPLING
+#define ZPP_MAYBE_SAMPLE_LOCATION_PARAMETER                                \
+    , const ::zpp::trace_location & location =                             \
+          ::zpp::trace_location::current()
+#define ZPP_MAYBE_SAMPLE_LOCATION_ARGUMENT , location
+#else
+#define ZPP_MAYBE_SAMPLE_LOCATION_PARAMETER
+#define ZPP_MAYBE_SAMPLE_LOCATION_ARGUMENT
+#endif
+
+/**
+ * This namespace is a workaround allowing us to delay the introduction of
+ * 'error' in this scope to avoid conflict with language rules in class
+ * 'maybe'.
+ */
+namespace error_detail
+{
+/**
+ * The category of errors whose category is not registered, either
+ * because the registry is full, because another category has the same
+ * identifier, or because the error was received from elsewhere and its
+ * category was never registered here.
+ */
+class unregistered_category : public error_category
+{
+public:
+    constexpr unregistered_category() : error_category(0)
+    {
+    }
+
+    std::string_view name() const noexcept override
+    {
+        return "zpp::unregistered_category";
+    }
+
+    std::string_view message(int) const noexcept override
+    {
+        return "Error category is not registered.";
+    }
+};
+
+/**
+ * The registry of error categories, mapping the stable identifier of
+ * a category to the category. The compact error mode stores only the
+ * identifier and uses the registry to find the category.
+ * The registry is a wait free open addressing table, lookups are a
+ * hash probe and registration happens once per category, the first
+ * time an error of that category is created in compact error mode,
+ * or explicitly using 'zpp::register_error_category'. Neither waits
+ * for a concurrent registration.
+ * Categories of the same identifier and name, such as the copies of a
+ * category in different shared objects, are considered the same.
+ */
+class category_registry
+{
+public:
+    /**
+     * The capacity of the registry.
+     */
+    static constexpr std::uint32_t capacity = ZPP_MAYBE_MAX_ERROR_CATEGORIES;
+
+    static_assert(capacity && !(capacity & (capacity - 1)),
+                  "The error category registry capacity must be a power "
+                  "of two.");
+
+    /**
+     * Returns the category of the given identifier, or null if there
+     * is no such registered category.
+     */
+    static const error_category * find(std::uint32_t id) noexcept
+    {
+        auto index = hash(id);
+        for (std::uint32_t probe = 0; probe != capacity; ++probe, ++index) {
+            auto & slot = s_slots[index & (capacity - 1)];
+            auto current = slot.id.load(std::memory_order_acquire);
+            const error_category * category{};
+            if (current == id) ZPP_MAYBE_LIKELY {
+                category = slot.category.load(std::memory_order_relaxed);
+            } else if (current) {
+                continue;
+            } else {
+                // The slot is free, or claimed but its identifier is not
+                // yet published.
+                category = slot.category.load(std::memory_order_acquire);
+                if (!category) {
+                    break;
+                }
+                if (category->id() != id) {
+                    continue;
+                }
+            }
+            return slot.conflict.load(std::memory_order_acquire) ? nullptr
+                                                                 : category;
+        }
+        return nullptr;
+    }
+
+    /**
+     * Returns the category of the given identifier, or the fallback
+     * category if there is no such registered category.
+     */
+    static const error_category & at(std::uint32_t id) noexcept
+    {
+        if (auto category = find(id)) ZPP_MAYBE_LIKELY {
+            return *category;
+        }
+        return s_unregistered;
+    }
+
+    /**
+     * Registers the given category if needed. Returns false if the
+     * registry is full, or if another category with the same identifier
+     * but a different name is registered, in which case neither is
+     * found by the identifier anymore, and errors carrying it report
+     * the fallback category rather than one of the two.
+     */
+    static bool add(const error_category & category) noexcept
+    {
+        auto id = category.id();
+        auto index = hash(id);
+        for (std::uint32_t probe = 0; probe != capacity; ++probe, ++index) {
+            auto & slot = s_slots[index & (capacity - 1)];
+            auto registered = slot.category.load(std::memory_order_acquire);
+            if (!registered) {
+                if (slot.category.compare_exchange_strong(
+                        registered,
+                        std::addressof(category),
+                        std::memory_order_acq_rel,
+                        std::memory_order_acquire)) {
+                    slot.id.store(id, std::memory_order_release);
+                    return true;
+                }
+                // Another thread claimed the slot, 'registered' is its
+                // category.
+            }
+            auto current = slot.id.load(std::memory_order_acquire);
+            if ((current ? current : registered->id()) != id) {
+                continue;
+            }
+            if (registered == std::addressof(category) ||
+                registered->name() == category.name()) {
+                return !slot.conflict.load(std::memory_order_acquire);
+            }
+            slot.conflict.store(true, std::memory_order_release);
+            return false;
+        }
+        return false;
+    }
+
+    /**
+     * Registers the given category if needed, and returns its
+     * identifier. Errors keep the identifier even if the category
+     * could not be registered, so that errors of distinct categories
+     * never compare equal.
+     */
+    static std::uint32_t id_of(const error_category & category) noexcept
+    {
+        if (category.m_registered.load(std::memory_order_relaxed))
+            ZPP_MAYBE_LIKELY {
+            return category.id();
+        }
+        return register_category(category);
+    }
+
+    /**
+     * Returns the identifier of the category of the given error code
+     * enumeration, registering the category once.
+     */
+    template <typename ErrorCode>
+    static std::uint32_t id_of() noexcept
+    {
+        // Zero until the dynamic initialization is done, in which
+        // case the category is registered directly.
+        if (auto id = s_id<ErrorCode>) ZPP_MAYBE_LIKELY {
+            return id;
+        }
+        return register_id<ErrorCode>();
+    }
+
+private:
+    /**
+     * Registers the given category and returns its identifier, kept
+     * out of line since it runs once per category, a failed registration
+     * is not retried.
+     */
+    ZPP_MAYBE_COLD static std::uint32_t
+    register_category(const error_category & category) noexcept
+    {
+        add(category);
+        category.m_registered.store(true, std::memory_order_relaxed);
+        return category.id();
+    }
+
+    /**
+     * Registers the category of the given error code enumeration and
+     * returns its identifier, kept out of line since it only runs
+     * before the dynamic initialization of the identifier.
+     */
+    template <typename ErrorCode>
+    ZPP_MAYBE_COLD static std::uint32_t register_id() noexcept
+    {
+        return id_of(zpp::category<ErrorCode>());
+    }
+
+    /**
+     * A registry slot, claimed by a single compare and swap of the
+     * category, the identifier is published after it so that lookups
+     * compare identifiers without loading the category.
+     */
+    struct slot
+    {
+        /**
+         * The category, null if the slot is free.
+         */
+        std::atomic<const error_category *> category;
+
+        /**
+         * The identifier of the category, zero until published.
+         */
+        std::atomic<std::uint32_t> id;
+
+        /**
+         * Whether another category with the same identifier but a
+         * different name was registered.
+         */
+        std::atomic<bool> conflict;
+    };
+
+    /**
+     * Returns the first slot index to probe for the given identifier.
+     */
+    static constexpr std::uint32_t hash(std::uint32_t id) noexcept
+    {
+        return std::uint32_t((std::uint64_t(id) * 0x9e3779b97f4a7c15) >>
+                             32);
+    }
+
+    /**
+     * The fallback category for categories that are not registered.
+     */
+    static constexpr unregistered_category s_unregistered{};
+
+    /**
+     * The registry slots, zero initialized.
+     */
+    inline static slot s_slots[capacity];
+
+    /**
+     * The identifier of the category of the given error code
+     * enumeration.
+     */
+    template <typename ErrorCode>
+    inline static const std::uint32_t s_id =
+        id_of(zpp::category<ErrorCode>());
+};
+
+#if ZPP_MAYBE_SAMPLING
+/**
+ * A sampled failing error, along with the location that constructed it.
+ */
+struct error_sample
+{
+    /**
+     * The number of backtrace frames that fit in a sample.
+     */
+    static constexpr std::size_t max_frames =
+        ZPP_MAYBE_SAMPLE_BACKTRACE ? ZPP_MAYBE_SAMPLE_BACKTRACE : 1;
+
+    /**
+     * The error category.
+     */
+    const error_category * category{};
+
+    /**
+     * The error code.
+     */
+    int code{};
+
+    /**
+     * The file name of the location that constructed the error.
+     */
+    const char * file{};
+
+    /**
+     * The function name of the location that constructed the error.
+     */
+    const char * function{};
+
+    /**
+     * The line number of the location that constructed the error.
+     */
+    std::uint_least32_t line{};
+
+    /**
+     * The number of backtrace frames captured.
+     */
+    std::size_t frames{};
+
+    /**
+     * The return addresses of the backtrace, innermost first.
+     */
+    void * backtrace[max_frames]{};
+};
+
+/**
+ * The sampled failing errors.
+ * Samples are written into a preallocated ring, each entry guarded by
+ * a sequence number that is odd while the entry is written, so that
+ * capturing never blocks, and readers skip entries that changed while
+ * they were read. A sample that finds its entry being written by
+ * another thread is dropped.
+ */
+class error_samples
+{
+public:
+    /**
+     * The number of samples that are kept.
+     */
+    static constexpr std::size_t capacity = ZPP_MAYBE_SAMPLE_CAPACITY;
+
+    static_assert(capacity && !(capacity & (capacity - 1)),
+                  "The sample capacity must be a power of two.");
+
+    /**
+     * The period of categories whose sampling is disabled.
+     */
+    static constexpr std::uint32_t disabled = ~std::uint32_t{};
+
+    /**
+     * Sets the sampling period of the given category, zero disables
+     * sampling of the category. Returns false if the periods of too
+     * many categories were set.
+     */
+    static bool set_period(const error_category & category,
+                           std::uint32_t period) noexcept
+    {
+        auto slot = find(category, true);
+        if (!slot) {
+            return false;
+        }
+        slot->period.store(period ? period : disabled,
+                           std::memory_order_relaxed);
+        s_epoch.fetch_add(1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * Returns the number of times a period was set, so that countdowns
+     * started from an older period are restarted.
+     */
+    static std::uint32_t epoch() noexcept
+    {
+        return s_epoch.load(std::memory_order_acquire);
+    }
+
+    /**
+     * Returns the sampling period of the given category.
+     */
+    static std::uint32_t period(const error_category & category) noexcept
+    {
+        auto slot = find(category, false);
+        auto period = slot ? slot->period.load(std::memory_order_relaxed)
+                           : std::uint32_t{};
+        return period ? period : ZPP_MAYBE_SAMPLE_PERIOD;
+    }
+
+    /**
+     * Captures a sample of a failing error of the given category and
+     * code, constructed at the given location, unless sampling of the
+     * category is disabled. Returns the number of failing errors until
+     * the next sample.
+     */
+    ZPP_MAYBE_COLD static std::uint32_t
+    capture(const error_category & category,
+            int code,
+            const trace_location & location) noexcept
+    {
+        auto period = error_samples::period(category);
+        if (period == disabled) {
+            return period;
+        }
+
+        void * backtrace[error_sample::max_frames];
+        std::size_t frames = 0;
+#if ZPP_MAYBE_SAMPLE_BACKTRACE
+        frames = std::size_t(
+            ::backtrace(backtrace, int(error_sample::max_frames)));
+#endif
+
+        auto & entry = s_entries[s_next.fetch_add(
+                                     1, std::memory_order_relaxed) &
+                                 (capacity - 1)];
+        auto sequence = entry.sequence.load(std::memory_order_relaxed);
+        if ((sequence & 1) ||
+            !entry.sequence.compare_exchange_strong(
+                sequence, sequence + 1, std::memory_order_relaxed)) {
+            return period;
+        }
+        std::atomic_thread_fence(std::memory_order_release);
+
+        entry.category.store(std::addressof(category),
+                             std::memory_order_relaxed);
+        entry.code.store(code, std::memory_order_relaxed);
+        entry.file.store(location.file_name(), std::memory_order_relaxed);
+        entry.function.store(location.function_name(),
+                             std::memory_order_relaxed);
+        entry.line.store(location.line(), std::memory_order_relaxed);
+        entry.frames.store(frames, std::memory_order_relaxed);
+        for (std::size_t index = 0; index != frames; ++index) {
+            entry.backtrace[index].store(backtrace[index],
+                                         std::memory_order_relaxed);
+        }
+
+        entry.sequence.store(sequence + 2, std::memory_order_release);
+        return period;
+    }
+
+    /**
+     * Writes up to 'size' of the kept samples into the given array.
+     * Returns the number of samples that were written.
+     */
+    static std::size_t snapshot(error_sample * samples,
+                                std::size_t size) noexcept
+    {
+        std::size_t written = 0;
+        for (auto & entry : s_entries) {
+            if (written == size) {
+                break;
+            }
+
+            auto sequence = entry.sequence.load(std::memory_order_acquire);
+            if (!sequence || (sequence & 1)) {
+                continue;
+            }
+
+            auto & sample = samples[written];
+            sample.category = entry.category.load(std::memory_order_relaxed);
+            sample.code = entry.code.load(std::memory_order_relaxed);
+            sample.file = entry.file.load(std::memory_order_relaxed);
+            sample.function =
+                entry.function.load(std::memory_order_relaxed);
+            sample.line = entry.line.load(std::memory_order_relaxed);
+            sample.frames = entry.frames.load(std::memory_order_relaxed);
+            for (std::size_t index = 0; index != sample.frames; ++index) {
+                sample.backtrace[index] =
+                    entry.backtrace[index].load(std::memory_order_relaxed);
+            }
+
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (entry.sequence.load(std::memory_order_relaxed) ==
+                sequence) {
+                ++written;
+            }
+        }
+        return written;
+    }
+
+private:
+    /**
+     * The sampling period of a category.
+     */
+    struct period_slot
+    {
+        /**
+         * The category, null if the slot is free.
+         */
+        std::atomic<const error_category *> category;
+
+        /**
+         * The period, zero until set, which means the default.
+         */
+        std::atomic<std::uint32_t> period;
+    };
+
+    /**
+     * A sample entry.
+     */
+    struct entry
+    {
+        /**
+         * The sequence number, odd while the entry is written, zero
+         * if the entry was never written.
+         */
+        std::atomic<std::uint64_t> sequence;
+
+        /**
+         * The error category.
+         */
+        std::atomic<const error_category *> category;
+
+        /**
+         * The error code.
+         */
+        std::atomic<int> code;
+
+        /**
+         * The file name.
+         */
+        std::atomic<const char *> file;
+
+        /**
+         * The function name.
+         */
+        std::atomic<const char *> function;
+
+        /**
+         * The line number.
+         */
+        std::atomic<std::uint_least32_t> line;
+
+        /**
+         * The number of backtrace frames.
+         */
+        std::atomic<std::size_t> frames;
+
+        /**
+         * The backtrace frames.
+         */
+        std::atomic<void *> backtrace[error_sample::max_frames];
+    };
+
+    /**
+     * The number of categories whose period can be set.
+     */
+    static constexpr std::size_t categories = ZPP_MAYBE_MAX_ERROR_CATEGORIES;
+
+    /**
+     * Returns the period slot of the given category, claiming a free
+     * one if requested. Returns null if there is none.
+     */
+    static period_slot * find(const error_category & category,
+                              bool claim) noexcept
+    {
+        auto value = reinterpret_cast<std::uintptr_t>(&category) >> 4;
+        auto index = std::size_t(
+            (std::uint64_t(value) * 0x9e3779b97f4a7c15) >> 32);
+        for (std::size_t probe = 0; probe != categories; ++probe, ++index) {
+            auto & slot = s_periods[index & (categories - 1)];
+            auto slot_category =
+                slot.category.load(std::memory_order_relaxed);
+            if (slot_category == std::addressof(category)) {
+                return std::addressof(slot);
+            }
+            if (!slot_category) {
+                if (!claim) {
+                    return nullptr;
+                }
+                if (slot.category.compare_exchange_strong(
+                        slot_category,
+                        std::addressof(category),
+                        std::memory_order_relaxed) ||
+                    slot_category == std::addressof(category)) {
+                    return std::addressof(slot);
+                }
+            }
+        }
+        return nullptr;
+    }
+
+    /**
+     * The sampling periods, keyed by category, zero initialized.
+     */
+    inline static period_slot s_periods[categories];
+
+    /**
+     * The sample entries, zero initialized.
+     */
+    inline static entry s_entries[capacity];
+
+    /**
+     * The number of samples captured, the next entry to write.
+     */
+    inline static std::atomic<std::uint64_t> s_next{};
+
+    /**
+     * The number of times a period was set.
+     */
+    inline static std::atomic<std::uint32_t> s_epoch{};
+};
+#endif
+
+#if ZPP_MAYBE_COUNTERS
+/**
+ * The number of failing errors of a category and code.
+ */
+struct error_count
+{
+    /**
+     * The error category.
+     */
+    const error_category * category{};
+
+    /**
+     * The error code.
+     */
+    int code{};
+
+    /**
+     * The number of failing errors constructed.
+     */
+    std::uint64_t count{};
+};
+
+/**
+ * The failing error counters.
+ * Each thread counts into a shard of its own, so that counting never
+ * contends on a cache line and a slot is claimed without atomic
+ * read-modify-write operations. Shards are allocated once, linked into
+ * a lock free list that is never shrunk, and reused by later threads
+ * after their owning thread exits, hence counts are never lost.
+ */
+class error_counters
+{
+public:
+    /**
+     * The number of slots in each shard.
+     */
+    static constexpr std::size_t slots = ZPP_MAYBE_COUNTER_SLOTS;
+
+    static_assert(slots && !(slots & (slots - 1)),
+                  "The number of counter slots must be a power of two.");
+
+    /**
+     * Counts a failing error of the given category and code, and
+     * samples it if it is due, when sampling is enabled.
+     */
+    ZPP_MAYBE_COLD static void
+    count(const error_category & category,
+          int code ZPP_MAYBE_SAMPLE_LOCATION_PARAMETER) noexcept
+    {
+        auto shard = this_thread_shard();
+        if (!shard) {
+            s_dropped.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+
+        auto index = hash(category, code);
+        for (std::size_t probe = 0; probe != slots; ++probe, ++index) {
+            auto & slot = shard->m_slots[index & (slots - 1)];
+            auto slot_category =
+                slot.category.load(std::memory_order_relaxed);
+            if (!slot_category) {
+                slot.code.store(code, std::memory_order_relaxed);
+                slot.count.store(1, std::memory_order_relaxed);
+                slot.category.store(std::addressof(category),
+                                    std::memory_order_release);
+#if ZPP_MAYBE_SAMPLING
+                // The first error of each slot is sampled.
+                slot.countdown = 1;
+                slot.epoch = error_samples::epoch();
+                sample(slot, category, code, location);
+#endif
+                return;
+            }
+            if (slot_category == std::addressof(category) &&
+                slot.code.load(std::memory_order_relaxed) == code) {
+                // Only the owning thread writes the slot.
+                slot.count.store(
+                    slot.count.load(std::memory_order_relaxed) + 1,
+                    std::memory_order_relaxed);
+#if ZPP_MAYBE_SAMPLING
+                sample(slot, category, code, location);
+#endif
+                return;
+            }
+        }
+        shard->m_dropped.store(
+            shard->m_dropped.load(std::memory_order_relaxed) + 1,
+            std::memory_order_relaxed);
+    }
+
+    /**
+     * Writes the counts of up to 'size' distinct category and code
+     * pairs, summed over all threads, into the given array. Returns
+     * the number of pairs that were written.
+     */
+    static std::size_t snapshot(error_count * counts,
+                                std::size_t size) noexcept
+    {
+        std::size_t written = 0;
+        for (auto shard = s_shards.load(std::memory_order_acquire); shard;
+             shard = shard->m_next) {
+            for (auto & slot : shard->m_slots) {
+                auto category = slot.category.load(std::memory_order_acquire);
+                if (!category) {
+                    continue;
+                }
+                auto code = slot.code.load(std::memory_order_relaxed);
+                auto count = slot.count.load(std::memory_order_relaxed);
+
+                std::size_t index = 0;
+                while (index != written &&
+                       (counts[index].category != category ||
+                        counts[index].code != code)) {
+                    ++index;
+                }
+                if (index != written) {
+                    counts[index].count += count;
+                } else if (written != size) {
+                    counts[written++] = error_count{category, code, count};
+                }
+            }
+        }
+        return written;
+    }
+
+    /**
+     * Returns the number of failing errors that were not counted since
+     * there was no slot or shard available for them.
+     */
+    static std::uint64_t dropped() noexcept
+    {
+        auto dropped = s_dropped.load(std::memory_order_relaxed);
+        for (auto shard = s_shards.load(std::memory_order_acquire); shard;
+             shard = shard->m_next) {
+            dropped += shard->m_dropped.load(std::memory_order_relaxed);
+        }
+        return dropped;
+    }
+
+private:
+    /**
+     * A counter slot, written only by the thread owning the shard.
+     */
+    struct slot
+    {
+        /**
+         * The category, published last, null if the slot is free.
+         */
+        std::atomic<const error_category *> category{};
+
+        /**
+         * The error code.
+         */
+        std::atomic<int> code{};
+
+        /**
+         * The count.
+         */
+        std::atomic<std::uint64_t> count{};
+
+#if ZPP_MAYBE_SAMPLING
+        /**
+         * The number of errors until the next sample, accessed only by
+         * the owning thread.
+         */
+        std::uint32_t countdown{};
+
+        /**
+         * The sampling epoch the countdown was started in, accessed only
+         * by the owning thread.
+         */
+        std::uint32_t epoch{};
+#endif
+    };
+
+    /**
+     * The counters of a single thread.
+     */
+    struct alignas(64) shard
+    {
+        /**
+         * The counter slots, an open addressing hash table.
+         */
+        slot m_slots[slots]{};
+
+        /**
+         * The number of errors that did not find a slot.
+         */
+        std::atomic<std::uint64_t> m_dropped{};
+
+        /**
+         * Whether a thread currently owns the shard.
+         */
+        std::atomic<bool> m_owned{};
+
+        /**
+         * The next shard, immutable once the shard is published.
+         */
+        shard * m_next{};
+    };
+
+    /**
+     * Owns a shard for the lifetime of a thread.
+     */
+    struct shard_owner
+    {
+        shard_owner() noexcept : m_shard(acquire())
+        {
+        }
+
+        ~shard_owner()
+        {
+            if (m_shard) {
+                m_shard->m_owned.store(false, std::memory_order_release);
+            }
+        }
+
+        shard * m_shard;
+    };
+
+#if ZPP_MAYBE_SAMPLING
+    /**
+     * Samples the error counted in the given slot if it is due, which
+     * for errors that are not sampled is a load, a decrement and two
+     * branches. A countdown started before a period was set restarts
+     * from the current period, rather than running out the old one,
+     * which is nearly 2^32 for disabled categories.
+     */
+    static void sample(slot & slot,
+                       const error_category & category,
+                       int code,
+                       const trace_location & location) noexcept
+    {
+        if (auto epoch = error_samples::epoch(); slot.epoch != epoch)
+            ZPP_MAYBE_UNLIKELY {
+            slot.epoch = epoch;
+            slot.countdown = error_samples::period(category);
+        }
+        if (!--slot.countdown) ZPP_MAYBE_UNLIKELY {
+            slot.countdown =
+                error_samples::capture(category, code, location);
+        }
+    }
+#endif
+
+    /**
+     * Returns the shard of the calling thread, null if it could not
+     * be allocated.
+     */
+    static shard * this_thread_shard() noexcept
+    {
+        thread_local shard_owner owner;
+        return owner.m_shard;
+    }
+
+    /**
+     * Acquires a shard that is not owned by any thread, allocating
+     * a new one if there is none.
+     */
+    static shard * acquire() noexcept
+    {
+        for (auto shard = s_shards.load(std::memory_order_acquire); shard;
+             shard = shard->m_next) {
+            bool owned = false;
+            if (!shard->m_owned.load(std::memory_order_relaxed) &&
+                shard->m_owned.compare_exchange_strong(
+                    owned, true, std::memory_order_acquire)) {
+                return shard;
+            }
+        }
+
+        auto created = new (std::nothrow) shard;
+        if (!created) {
+            return nullptr;
+        }
+        created->m_owned.store(true, std::memory_order_relaxed);
+        created->m_next = s_shards.load(std::memory_order_relaxed);
+        while (!s_shards.compare_exchange_weak(created->m_next,
+                                               created,
+                                               std::memory_order_release,
+                                               std::memory_order_relaxed)) {
+        }
+        return created;
+    }
+
+    /**
+     * Returns the hash of the given category and code.
+     */
+    static std::size_t hash(const error_category & category,
+                            int code) noexcept
+    {
+        auto value = (reinterpret_cast<std::uintptr_t>(&category) >> 4) ^
+                     std::uint32_t(code);
+        return std::size_t((std::uint64_t(value) * 0x9e3779b97f4a7c15) >>
+                           32);
+    }
+
+    /**
+     * The list of shards.
+     */
+    inline static std::atomic<shard *> s_shards{};
+
+    /**
+     * The number of errors that did not find a shard.
+     */
+    inline static std::atomic<std::uint64_t> s_dropped{};
+};
+#endif
+
+/**
+ * Represents an error to be initialized from an error code
+ * enumeration.
+ * The error code enumeration must have 'int' as underlying type.
+ * Defining an error code enum and a category for it goes as follows.
+ * Example:
+ * ~~~
+ * namespace my_namespace
+ * {
+ * enum class my_error : int
+ * {
+ *     success = 0,
+ *     something_bad = 1,
+ *     something_really_bad = 2,
+ * };
+ *
+ * inline const zpp::error_category & category(my_error)
+ * {
+ *     constexpr static auto error_category =
+ *         zpp::make_error_category("my_category", my_error::success,
+ *             [](auto code) -> std::string_view {
+ *                 switch (code) {
+ *                     case my_error::success:
+ *                         return zpp::error::no_error;
+ *                     case my_code:something_bad:
+ *                         return "Something bad happened.";
+ *                     case my_error::something_really_bad:
+ *                         return "Something really bad happened.";
+ *                     default:
+ *                         return "Unknown error occurred.";
+ *                 }
+ *             }
+ *         );
+ *     return error_category;
+ * }
+ * } // my_namespace
+ * ~~~
+ * Alternatively, the category may be defined as a constant namespace
+ * scope object using 'zpp::define_error_category'.
+ */
+class error
+{
+public:
+    /**
+     * Disables default construction.
+     */
+    error() = delete;
+
+    /**
+     * Constructs an error from an error code enumeration, the
+     * category is looked by using argument dependent lookup on a
+     * function named 'category' that receives the error code
+     * enumeration value.
+     */
+    template <typename ErrorCode,
+              typename = std::enable_if_t<std::is_enum_v<ErrorCode>>>
+    constexpr error(ErrorCode error_code
+                        ZPP_MAYBE_SAMPLE_LOCATION_PARAMETER) :
+#if ZPP_MAYBE_COMPACT_ERROR
+        m_value((std::uint64_t(ZPP_MAYBE_IS_CONSTANT_EVALUATED()
+                                   ? zpp::category<ErrorCode>().id()
+                                   : category_registry::id_of<ErrorCode>())
+                 << 33) |
+                encode(zpp::category<ErrorCode>(),
+                       std::underlying_type_t<ErrorCode>(error_code)))
+#else
+        m_category(std::addressof(zpp::category<ErrorCode>())),
+        m_code(encode(*m_category,
+                      std::underlying_type_t<ErrorCode>(error_code)))
+#endif
+    {
+#if ZPP_MAYBE_COUNTERS
+        if (!ZPP_MAYBE_IS_CONSTANT_EVALUATED() && !*this) {
+            error_counters::count(zpp::category<ErrorCode>(),
+                                  code() ZPP_MAYBE_SAMPLE_LOCATION_ARGUMENT);
+        }
+#endif
+    }
+
+    /**
+     * Constructs an error from an error code enumeration, the
      * category is given explicitly in this overload.
      */
-    template <typename ErrorCode>
-    error(ErrorCode error_code, const error_category & category) :
-        m_category(std::addressof(category)),
-        m_code(std::underlying_type_t<ErrorCode>(error_code))
+    template <typename ErrorCode,
+              typename = std::enable_if_t<std::is_enum_v<ErrorCode>>>
+    constexpr error(ErrorCode error_code,
+                    const error_category & category
+                        ZPP_MAYBE_SAMPLE_LOCATION_PARAMETER) :
+#if ZPP_MAYBE_COMPACT_ERROR
+        m_value((std::uint64_t(ZPP_MAYBE_IS_CONSTANT_EVALUATED()
+                                   ? category.id()
+                                   : category_registry::id_of(category))
+                 << 33) |
+                encode(category,
+                       std::underlying_type_t<ErrorCode>(error_code)))
+#else
+        m_category(std::addressof(category)),
+        m_code(encode(category,
+                      std::underlying_type_t<ErrorCode>(error_code)))
+#endif
+    {
+#if ZPP_MAYBE_COUNTERS
+        if (!ZPP_MAYBE_IS_CONSTANT_EVALUATED() && !*this) {
+            error_counters::count(
+                category, code() ZPP_MAYBE_SAMPLE_LOCATION_ARGUMENT);
+        }
+#endif
+    }
+
+#if ZPP_MAYBE_COMPACT_ERROR
+    /**
+     * Returns the error category.
+     * In compact error mode this is a registry lookup and therefore
+     * is not usable in constant expressions.
+     */
+    const error_category & category() const
+    {
+        return category_registry::at(category_id());
+    }
+
+    /**
+     * Returns the stable identifier of the error category, which
+     * is stored in the error itself in compact error mode.
+     */
+    constexpr std::uint32_t category_id() const noexcept
+    {
+        return encoded_category() >> 1;
+    }
+#else
+    /**
+     * Returns the error category.
+     */
+    constexpr const error_category & category() const
+    {
+        return *m_category;
+    }
+
+    /**
+     * Returns the stable identifier of the error category.
+     */
+    constexpr std::uint32_t category_id() const noexcept
+    {
+        return m_category->id();
+    }
+#endif
+
+    /**
+     * Returns the error code.
+     */
+    constexpr int code() const
+    {
+#if ZPP_MAYBE_COMPACT_ERROR
+        return int(std::uint32_t(m_value));
+#else
+        return int(std::uint32_t(m_code));
+#endif
+    }
+
+    /**
+     * Returns the error message. Calling this on
+     * a success error is implementation defined according
+     * to the error category.
+     */
+#if !ZPP_MAYBE_COMPACT_ERROR
+    ZPP_MAYBE_CONSTEXPR20
+#endif
+    std::string_view message() const
+    {
+        return category().message(code());
+    }
+
+    /**
+     * Returns true if the error indicates success, else false.
+     * The success indication is computed at construction, hence
+     * this does not access the category.
+     */
+    constexpr explicit operator bool() const
+    {
+#if ZPP_MAYBE_COMPACT_ERROR
+        return m_value & success_flag;
+#else
+        return m_code & success_flag;
+#endif
+    }
+
+    /**
+     * Returns true if the error is of the given error code, else false.
+     * For categories defined with 'zpp::define_error_category' the
+     * expected encoding is a constant, and in compact error mode this
+     * is a single compare.
+     */
+    template <typename ErrorCode,
+              typename = std::enable_if_t<std::is_enum_v<ErrorCode>>>
+    constexpr bool is(ErrorCode error_code) const noexcept
+    {
+        const auto & category = zpp::category<ErrorCode>();
+        auto code = std::underlying_type_t<ErrorCode>(error_code);
+#if ZPP_MAYBE_COMPACT_ERROR
+        return m_value ==
+               ((std::uint64_t(category.id()) << 33) | encode(category, code));
+#else
+        return m_code == encode(category, code) &&
+               (m_category == std::addressof(category) ||
+                m_category->id() == category.id());
+#endif
+    }
+
+    /**
+     * Returns true if the error is of the given error code, else false,
+     * as above.
+     * Example:
+     * ~~~
+     * if (error.is<my_error::something_bad>()) {
+     *     // Retry.
+     * }
+     * ~~~
+     */
+    template <auto ErrorCode>
+    constexpr bool is() const noexcept
+    {
+        static_assert(std::is_enum_v<decltype(ErrorCode)>,
+                      "The error code must be an enumeration value.");
+        return is(ErrorCode);
+    }
+
+    /**
+     * Returns true if the errors have the same category and code.
+     * Categories are the same if they are the same object, or if they
+     * have the same identifier, such as copies of a category in
+     * different shared objects.
+     */
+    friend constexpr bool operator==(const error & left,
+                                     const error & right) noexcept
+    {
+#if ZPP_MAYBE_COMPACT_ERROR
+        return left.m_value == right.m_value;
+#else
+        return left.m_code == right.m_code &&
+               (left.m_category == right.m_category ||
+                left.m_category->id() == right.m_category->id());
+#endif
+    }
+
+    /**
+     * Returns true if the errors differ in category or code.
+     */
+    friend constexpr bool operator!=(const error & left,
+                                     const error & right) noexcept
+    {
+        return !(left == right);
+    }
+
+    /**
+     * Returns true if the error is of the given error code.
+     */
+    template <typename ErrorCode,
+              typename = std::enable_if_t<std::is_enum_v<ErrorCode>>>
+    friend constexpr bool operator==(const error & error,
+                                     ErrorCode error_code) noexcept
+    {
+        return error.is(error_code);
+    }
+
+    /**
+     * Returns true if the error is of the given error code.
+     */
+    template <typename ErrorCode,
+              typename = std::enable_if_t<std::is_enum_v<ErrorCode>>>
+    friend constexpr bool operator==(ErrorCode error_code,
+                                     const error & error) noexcept
+    {
+        return error.is(error_code);
+    }
+
+    /**
+     * Returns true if the error is not of the given error code.
+     */
+    template <typename ErrorCode,
+              typename = std::enable_if_t<std::is_enum_v<ErrorCode>>>
+    friend constexpr bool operator!=(const error & error,
+                                     ErrorCode error_code) noexcept
+    {
+        return !error.is(error_code);
+    }
+
+    /**
+     * Returns true if the error is not of the given error code.
+     */
+    template <typename ErrorCode,
+              typename = std::enable_if_t<std::is_enum_v<ErrorCode>>>
+    friend constexpr bool operator!=(ErrorCode error_code,
+                                     const error & error) noexcept
+    {
+        return !error.is(error_code);
+    }
+
+    /**
+     * No error message value.
+     */
+    static constexpr std::string_view no_error{};
+
+private:
+    /**
+     * Allow maybe to reconstruct errors from its storage.
+     */
+    template <typename, typename>
+    friend class zpp::maybe;
+
+    /**
+     * Allow the maybe storage to store the encoded error.
+     */
+    template <typename, typename, bool>
+    friend struct maybe_detail::storage;
+
+    /**
+     * Allow the maybe storage operations to store the error of a lost
+     * value.
+     */
+    template <typename, typename>
+    friend struct maybe_detail::operations;
+
+    /**
+     * Allow the maybe storage to store the encoded error code
+     * along with the payload.
+     */
+    template <typename>
+    friend struct maybe_detail::error_body;
+
+    /**
+     * Allow the wire format to decode errors.
+     */
+    friend struct wire_detail::access;
+
+    /**
+     * The flag that is set in the encoded error for success codes,
+     * the error code itself is encoded in the lower 32 bits.
+     */
+    static constexpr std::uint64_t success_flag = std::uint64_t(1) << 32;
+
+    /**
+     * Encodes the error code along with its success flag.
+     */
+    static constexpr std::uint64_t encode(const error_category & category,
+                                          int code)
+    {
+        return std::uint32_t(code) |
+               (category.success(code) ? success_flag : 0);
+    }
+
+#if ZPP_MAYBE_COMPACT_ERROR
+    /**
+     * The encoded category - the identifier of the category
+     * followed by the success flag, never zero.
+     */
+    using encoded_category_type = std::uint32_t;
+
+    /**
+     * The encoded error code.
+     */
+    using encoded_code_type = std::uint32_t;
+#else
+    /**
+     * The encoded category - a pointer to the category, never null.
+     */
+    using encoded_category_type = const error_category *;
+
+    /**
+     * The encoded error code along with the success flag.
+     */
+    using encoded_code_type = std::uint64_t;
+#endif
+
+    /**
+     * Constructs an error from an encoded category and code.
+     */
+    constexpr error(encoded_category_type category, encoded_code_type code) :
+#if ZPP_MAYBE_COMPACT_ERROR
+        m_value((std::uint64_t(category) << 32) | code)
+#else
+        m_category(category), m_code(code)
+#endif
+    {
+    }
+
+    /**
+     * Returns the encoded category.
+     */
+    constexpr encoded_category_type encoded_category() const
+    {
+#if ZPP_MAYBE_COMPACT_ERROR
+        return encoded_category_type(m_value >> 32);
+#else
+        return m_category;
+#endif
+    }
+
+    /**
+     * Returns the encoded error code.
+     */
+    constexpr encoded_code_type encoded_code() const
+    {
+#if ZPP_MAYBE_COMPACT_ERROR
+        return encoded_code_type(m_value);
+#else
+        return m_code;
+#endif
+    }
+
+#if ZPP_MAYBE_COMPACT_ERROR
+    /**
+     * The category identifier and success flag in the upper half and
+     * the error code in the lower half.
+     */
+    std::uint64_t m_value{};
+#else
+    /**
+     * The error category.
+     */
+    const error_category * m_category{};
+
+    /**
+     * The error code and the success flag.
+     */
+    std::uint64_t m_code{};
+#endif
+};
+
+/**
+ * An error that carries a small payload next to the error code, such as
+ * a byte offset, a file descriptor or a sub code - without any heap
+ * allocation. The payload must be trivially copyable and at most eight
+ * bytes long, it is stored inline and is copied along with the error.
+ *
+ * A basic error is an error, converting it to a plain error drops the
+ * payload, and a plain error converts to a basic error with a value
+ * initialized payload.
+ * Example:
+ * ~~~
+ * zpp::maybe<int, std::uint32_t> parse(std::string_view text)
+ * {
+ *     for (std::uint32_t offset = 0; offset < text.size(); ++offset) {
+ *         if (!std::isdigit(text[offset])) {
+ *             // Fail with the offset of the bad character.
+ *             return zpp::basic_error<std::uint32_t>(
+ *                 my_error::something_bad, offset);
+ *         }
+ *     }
+ *
+ *     return 1337;
+ * }
+ *
+ * if (auto result = parse("13x7"); !result) {
+ *     std::cout << result.error().message() << " at "
+ *         << result.error().payload() << '\n';
+ * }
+ * ~~~
+ */
+template <typename Payload>
+class basic_error : public error
+{
+public:
+    static_assert(std::is_trivially_copyable_v<Payload>,
+                  "The error payload must be trivially copyable.");
+    static_assert(sizeof(Payload) <= sizeof(std::uint64_t),
+                  "The error payload must not be larger than eight bytes.");
+
+    /**
+     * The type of the payload.
+     */
+    using payload_type = Payload;
+
+    /**
+     * Disables default construction.
+     */
+    basic_error() = delete;
+
+    /**
+     * Constructs an error from an error code enumeration and a payload,
+     * the category is looked up as in the plain error.
+     */
+    template <typename ErrorCode,
+              typename = std::enable_if_t<std::is_enum_v<ErrorCode>>>
+    constexpr basic_error(ErrorCode error_code,
+                          const Payload & payload = Payload{}
+                              ZPP_MAYBE_SAMPLE_LOCATION_PARAMETER) :
+        error(error_code ZPP_MAYBE_SAMPLE_LOCATION_ARGUMENT),
+        m_payload(payload)
+    {
+    }
+
+    /**
+     * Constructs an error from a plain error and a payload.
+     */
+    constexpr basic_error(const error & other,
+                          const Payload & payload = Payload{}) :
+        error(other), m_payload(payload)
+    {
+    }
+
+    /**
+     * Returns the payload.
+     */
+    constexpr const Payload & payload() const noexcept
+    {
+        return m_payload;
+    }
+
+private:
+    /**
+     * The payload.
+     */
+    Payload m_payload;
+};
+} // namespace error_detail
+
+/**
+ * The errors of the maybe itself.
+ */
+enum class maybe_error : int
+{
+    success = 0,
+    valueless = 1,
+};
+
+/**
+ * The error category of the maybe itself.
+ */
+template <>
+inline constexpr auto define_error_category<maybe_error> =
+    make_error_category("zpp::maybe_error",
+                        maybe_error::success,
+                        {
+                            {maybe_error::success,
+                             error_detail::error::no_error},
+                            {maybe_error::valueless,
+                             "The value was lost by a throwing replace."},
+                        });
+
+#if ZPP_MAYBE_TRACE
+/**
+ * An entry of the error trace.
+ */
+struct trace_entry
+{
+    /**
+     * The category of the traced error.
+     */
+    const error_category * category{};
+
+    /**
+     * The code of the traced error.
+     */
+    int code{};
+
+    /**
+     * Where the error was traced.
+     */
+    trace_location location{};
+};
+
+/**
+ * A fixed size ring buffer of trace entries, once full, new entries
+ * overwrite the oldest ones. A ring is written only by its own thread,
+ * without locks or allocation, and may be read by that thread at any
+ * time, including from a signal handler that interrupted it - in which
+ * case the oldest entry may be in the middle of being overwritten.
+ */
+template <std::size_t Capacity>
+class trace_ring
+{
+    static_assert(Capacity && !(Capacity & (Capacity - 1)),
+                  "The trace capacity must be a power of two.");
+
+public:
+    /**
+     * Records the given failing error at the given location.
+     */
+    void record(const error_detail::error & error,
+                const trace_location & location) noexcept
+    {
+        auto count = m_count.load(std::memory_order_relaxed);
+        m_entries[count & (Capacity - 1)] =
+            trace_entry{std::addressof(error.category()),
+                        error.code(),
+                        location};
+        std::atomic_signal_fence(std::memory_order_release);
+        m_count.store(count + 1, std::memory_order_relaxed);
+    }
+
+    /**
+     * Returns the number of entries held in the ring.
+     */
+    std::size_t size() const noexcept
+    {
+        auto count = m_count.load(std::memory_order_relaxed);
+        return count < Capacity ? count : Capacity;
+    }
+
+    /**
+     * Returns the number of entries recorded since the last clear,
+     * including the ones that were overwritten.
+     */
+    std::size_t recorded() const noexcept
+    {
+        return m_count.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * Returns the capacity of the ring.
+     */
+    static constexpr std::size_t capacity() noexcept
+    {
+        return Capacity;
+    }
+
+    /**
+     * Calls the given function with each of the entries held in the
+     * ring, from the oldest to the newest.
+     */
+    template <typename Function>
+    void for_each(Function && function) const
+    {
+        auto count = m_count.load(std::memory_order_relaxed);
+        std::atomic_signal_fence(std::memory_order_acquire);
+        auto first = count < Capacity ? 0 : count - Capacity;
+        for (auto index = first; index != count; ++index) {
+            function(m_entries[index & (Capacity - 1)]);
+        }
+    }
+
+    /**
+     * Removes all entries from the ring.
+     */
+    void clear() noexcept
+    {
+        m_count.store(0, std::memory_order_relaxed);
+    }
+
+private:
+    /**
+     * The entries.
+     */
+    trace_entry m_entries[Capacity]{};
+
+    /**
+     * The number of recorded entries, the next entry is written at
+     * this count modulo the capacity.
+     */
+    std::atomic<std::size_t> m_count{};
+};
+
+/**
+ * Returns the error trace ring of the calling thread.
+ */
+inline trace_ring<ZPP_MAYBE_TRACE_CAPACITY> & this_thread_trace() noexcept
+{
+    thread_local trace_ring<ZPP_MAYBE_TRACE_CAPACITY> ring;
+    return ring;
+}
+#endif
+
+/**
+ * Implementation details of the maybe storage.
+ */
+namespace maybe_detail
+{
+#if ZPP_MAYBE_TRACE
+/**
+ * Records the given error into the trace ring of the calling thread,
+ * marked cold as tracing takes place on error paths only.
+ */
+ZPP_MAYBE_COLD inline void trace(const error_detail::error & error,
+                                 const trace_location & location) noexcept
+{
+    this_thread_trace().record(error, location);
+}
+#endif
+
+/**
+ * Tag type used to construct a storage whose value or error is
+ * constructed later by the derived layer.
+ */
+struct uninitialized_t
+{
+};
+
+/**
+ * Constructs an object at the given address from the given arguments,
+ * through 'std::construct_at' during constant evaluation, where
+ * placement new is not allowed.
+ */
+template <typename Type, typename... Arguments>
+ZPP_MAYBE_CONSTEXPR20 void construct_value(Type * address,
+                                           Arguments &&... arguments)
+{
+#if defined(__cpp_lib_constexpr_dynamic_alloc)
+    if (ZPP_MAYBE_IS_CONSTANT_EVALUATED()) {
+        std::construct_at(address, std::forward<Arguments>(arguments)...);
+        return;
+    }
+#endif
+    ::new (static_cast<void *>(address))
+        Type(std::forward<Arguments>(arguments)...);
+}
+
+/**
+ * Destroys the object at the given address, through 'std::destroy_at'
+ * during constant evaluation.
+ */
+template <typename Type>
+ZPP_MAYBE_CONSTEXPR20 void destroy_value(Type * address)
+{
+#if defined(__cpp_lib_constexpr_dynamic_alloc)
+    if (ZPP_MAYBE_IS_CONSTANT_EVALUATED()) {
+        std::destroy_at(address);
+        return;
+    }
+#endif
+    address->~Type();
+}
+
+/**
+ * The part of the error that shares its place with the value in the
+ * maybe storage - the encoded error code, followed by the payload if
+ * there is one.
+ */
+template <typename Payload>
+struct error_body
+{
+    /**
+     * The error type that is stored.
+     */
+    using error_type = error_detail::basic_error<Payload>;
+
+    /**
+     * Returns the body of the given error.
+     */
+    static constexpr error_body from(const error_type & error)
+    {
+        return {error.encoded_code(), error.payload()};
+    }
+
+    /**
+     * Reconstructs the error from the body and the encoded category.
+     */
+    constexpr error_type
+    to_error(error_detail::error::encoded_category_type category) const
+    {
+        return error_type(error_detail::error(category, code), payload);
+    }
+
+    /**
+     * The encoded error code.
+     */
+    error_detail::error::encoded_code_type code;
+
+    /**
+     * The payload.
+     */
+    Payload payload;
+};
+
+/**
+ * The error body of errors without a payload.
+ */
+template <>
+struct error_body<void>
+{
+    /**
+     * The error type that is stored.
+     */
+    using error_type = error_detail::error;
+
+    /**
+     * Returns the body of the given error.
+     */
+    static constexpr error_body from(const error_type & error)
+    {
+        return {error.encoded_code()};
+    }
+
+    /**
+     * Reconstructs the error from the body and the encoded category.
+     */
+    constexpr error_type
+    to_error(error_detail::error::encoded_category_type category) const
+    {
+        return error_type(category, code);
+    }
+
+    /**
+     * The encoded error code.
+     */
+    error_detail::error::encoded_code_type code;
+};
+
+/**
+ * The maybe storage, the value shares its place with the error code and
+ * the encoded error category serves as the discriminant - a null category
+ * pointer, or a zero category index in compact error mode, indicates that
+ * a value is stored. This keeps 'maybe<int>' at the size of the error
+ * itself, and trivially copyable types remain trivially copyable.
+ *
+ * This is the storage for trivially destructible types.
+ */
+template <typename Type, typename Payload, bool TriviallyDestructible>
+struct storage
+{
+    /**
+     * Constructs an uninitialized storage.
+     */
+    ZPP_MAYBE_CONSTEXPR20 explicit storage(uninitialized_t)
+    {
+    }
+
+    /**
+     * Constructs the value in place from the given arguments.
+     */
+    template <typename... Arguments>
+    constexpr explicit storage(std::in_place_t, Arguments &&... arguments) :
+        m_value(std::forward<Arguments>(arguments)...)
+    {
+    }
+
+    /**
+     * Constructs the storage from an error.
+     */
+    constexpr storage(
+        const typename error_body<Payload>::error_type & error) :
+        m_error(error_body<Payload>::from(error)),
+        m_category(error.encoded_category())
+    {
+    }
+
+    /**
+     * Destroys the stored value if exists, the storage is left
+     * uninitialized.
+     */
+    constexpr void destroy()
+    {
+    }
+
+    /**
+     * The value or the error code and payload.
+     */
+    union
+    {
+        Type m_value;
+        error_body<Payload> m_error;
+    };
+
+    /**
+     * The encoded error category, null when a value is stored.
+     */
+    error_detail::error::encoded_category_type m_category{};
+};
+
+/**
+ * The maybe storage for types that are not trivially destructible.
+ */
+template <typename Type, typename Payload>
+struct storage<Type, Payload, false>
+{
+    /**
+     * Constructs an uninitialized storage.
+     */
+    ZPP_MAYBE_CONSTEXPR20 explicit storage(uninitialized_t)
+    {
+    }
+
+    /**
+     * Constructs the value in place from the given arguments.
+     */
+    template <typename... Arguments>
+    constexpr explicit storage(std::in_place_t,
+                               Arguments &&... arguments) :
+        m_value(std::forward<Arguments>(arguments)...)
+    {
+    }
+
+    /**
+     * Constructs the storage from an error.
+     */
+    constexpr storage(
+        const typename error_body<Payload>::error_type & error) :
+        m_error(error_body<Payload>::from(error)),
+        m_category(error.encoded_category())
+    {
+    }
+
+    /**
+     * Destroys the storage.
+     */
+    ZPP_MAYBE_CONSTEXPR20 ~storage()
+    {
+        destroy();
+    }
+
+    /**
+     * Destroys the stored value if exists, the storage is left
+     * uninitialized.
+     */
+    ZPP_MAYBE_CONSTEXPR20 void destroy()
+    {
+        if (!m_category) {
+            destroy_value(std::addressof(m_value));
+        }
+    }
+
+    /**
+     * The value or the error code and payload.
+     */
+    union
+    {
+        Type m_value;
+        error_body<Payload> m_error;
+    };
+
+    /**
+     * The encoded error category, null when a value is stored.
+     */
+    error_detail::error::encoded_category_type m_category{};
+};
+
+/**
+ * Adds construct and assign operations over the storage.
+ */
+template <typename Type, typename Payload>
+struct operations
+    : storage<Type, Payload, std::is_trivially_destructible_v<Type>>
+{
+    using storage<Type, Payload, std::is_trivially_destructible_v<Type>>::
+        storage;
+
+    /**
+     * Constructs the contents of the storage from another storage,
+     * the current contents must be uninitialized.
+     */
+    template <typename Other>
+    ZPP_MAYBE_CONSTEXPR20 void construct_from(Other && other)
+    {
+        if (!other.m_category) {
+            construct_value(std::addressof(this->m_value),
+                            std::forward<Other>(other).m_value);
+        } else {
+            this->m_error = other.m_error;
+        }
+        this->m_category = other.m_category;
+    }
+
+    /**
+     * Replaces the contents of the storage with a value constructed
+     * from the given arguments.
+     */
+    template <typename... Arguments>
+    ZPP_MAYBE_CONSTEXPR20 void emplace_value(Arguments &&... arguments)
+    {
+        if constexpr (std::is_nothrow_constructible_v<Type,
+                                                      Arguments &&...>) {
+            this->destroy();
+            construct_value(std::addressof(this->m_value),
+                            std::forward<Arguments>(arguments)...);
+        } else if constexpr (std::is_nothrow_move_constructible_v<Type>) {
+            // Construct first so that a throwing constructor leaves
+            // the storage intact, the value is then moved in after the
+            // old contents are destroyed.
+            Type value(std::forward<Arguments>(arguments)...);
+            this->destroy();
+            construct_value(std::addressof(this->m_value), std::move(value));
+        } else {
+            // Without a non throwing move the value is constructed in
+            // place. A throwing constructor restores a stored error, but
+            // a stored value is already destroyed, and is replaced by
+            // 'maybe_error::valueless'.
+#if defined(__cpp_exceptions)
+            if (this->m_category) {
+                auto error = this->m_error;
+                try {
+                    construct_value(std::addressof(this->m_value),
+                                    std::forward<Arguments>(arguments)...);
+                } catch (...) {
+                    this->m_error = error;
+                    throw;
+                }
+            } else {
+                this->destroy();
+                try {
+                    construct_value(std::addressof(this->m_value),
+                                    std::forward<Arguments>(arguments)...);
+                } catch (...) {
+                    set_valueless();
+                    throw;
+                }
+            }
+#else
+            this->destroy();
+            construct_value(std::addressof(this->m_value),
+                            std::forward<Arguments>(arguments)...);
+#endif
+        }
+        this->m_category = {};
+    }
+
+    /**
+     * Stores 'maybe_error::valueless' in place of a value that was
+     * destroyed and could not be replaced.
+     */
+    ZPP_MAYBE_COLD ZPP_MAYBE_CONSTEXPR20 void set_valueless() noexcept
+    {
+        typename error_body<Payload>::error_type valueless =
+            error_detail::error(maybe_error::valueless);
+        this->m_error = error_body<Payload>::from(valueless);
+        this->m_category = valueless.encoded_category();
+    }
+
+    /**
+     * Assigns the contents of another storage to this storage.
+     */
+    template <typename Other>
+    ZPP_MAYBE_CONSTEXPR20 void assign_from(Other && other)
+    {
+        if (!other.m_category) {
+            if (!this->m_category) {
+                this->m_value = std::forward<Other>(other).m_value;
+            } else {
+                emplace_value(std::forward<Other>(other).m_value);
+            }
+            return;
+        }
+        this->destroy();
+        this->m_error = other.m_error;
+        this->m_category = other.m_category;
+    }
+};
+
+/**
+ * Adds a copy constructor if the type is copy constructible but not
+ * trivially, otherwise the default is either trivial or deleted.
+ */
+template <typename Type,
+          typename Payload,
+          bool = std::is_trivially_copy_constructible_v<Type> ||
+                 !std::is_copy_constructible_v<Type>>
+struct copy_construct : operations<Type, Payload>
+{
+    using operations<Type, Payload>::operations;
+};
+
+template <typename Type, typename Payload>
+struct copy_construct<Type, Payload, false> : operations<Type, Payload>
+{
+    using operations<Type, Payload>::operations;
+
+    ZPP_MAYBE_CONSTEXPR20
+    copy_construct(const copy_construct & other) noexcept(
+        std::is_nothrow_copy_constructible_v<Type>) :
+        operations<Type, Payload>(uninitialized_t{})
+    {
+        this->construct_from(other);
+    }
+
+    copy_construct(copy_construct &&) = default;
+    copy_construct & operator=(const copy_construct &) = default;
+    copy_construct & operator=(copy_construct &&) = default;
+};
+
+/**
+ * Adds a move constructor if the type is move constructible but not
+ * trivially, otherwise the default is either trivial or deleted.
+ */
+template <typename Type,
+          typename Payload,
+          bool = std::is_trivially_move_constructible_v<Type> ||
+                 !std::is_move_constructible_v<Type>>
+struct move_construct : copy_construct<Type, Payload>
+{
+    using copy_construct<Type, Payload>::copy_construct;
+};
+
+template <typename Type, typename Payload>
+struct move_construct<Type, Payload, false> : copy_construct<Type, Payload>
+{
+    using copy_construct<Type, Payload>::copy_construct;
+
+    move_construct(const move_construct &) = default;
+
+    ZPP_MAYBE_CONSTEXPR20
+    move_construct(move_construct && other) noexcept(
+        std::is_nothrow_move_constructible_v<Type>) :
+        copy_construct<Type, Payload>(uninitialized_t{})
+    {
+        this->construct_from(std::move(other));
+    }
+
+    move_construct & operator=(const move_construct &) = default;
+    move_construct & operator=(move_construct &&) = default;
+};
+
+/**
+ * Adds a copy assignment if the type is copy constructible and copy
+ * assignable but not trivially, otherwise the default is either trivial
+ * or deleted.
+ */
+template <typename Type,
+          typename Payload,
+          bool = (std::is_trivially_copy_constructible_v<Type> &&
+                  std::is_trivially_copy_assignable_v<Type> &&
+                  std::is_trivially_destructible_v<Type>) ||
+                 !(std::is_copy_constructible_v<Type> &&
+                   std::is_copy_assignable_v<Type>)>
+struct copy_assign : move_construct<Type, Payload>
+{
+    using move_construct<Type, Payload>::move_construct;
+};
+
+template <typename Type, typename Payload>
+struct copy_assign<Type, Payload, false> : move_construct<Type, Payload>
+{
+    using move_construct<Type, Payload>::move_construct;
+
+    copy_assign(const copy_assign &) = default;
+    copy_assign(copy_assign &&) = default;
+
+    ZPP_MAYBE_CONSTEXPR20
+    copy_assign & operator=(const copy_assign & other) noexcept(
+        std::is_nothrow_copy_constructible_v<Type> &&
+            std::is_nothrow_copy_assignable_v<Type>)
+    {
+        this->assign_from(other);
+        return *this;
+    }
+
+    copy_assign & operator=(copy_assign &&) = default;
+};
+
+/**
+ * Adds a move assignment if the type is move constructible and move
+ * assignable but not trivially, otherwise the default is either trivial
+ * or deleted.
+ */
+template <typename Type,
+          typename Payload,
+          bool = (std::is_trivially_move_constructible_v<Type> &&
+                  std::is_trivially_move_assignable_v<Type> &&
+                  std::is_trivially_destructible_v<Type>) ||
+                 !(std::is_move_constructible_v<Type> &&
+                   std::is_move_assignable_v<Type>)>
+struct move_assign : copy_assign<Type, Payload>
+{
+    using copy_assign<Type, Payload>::copy_assign;
+};
+
+template <typename Type, typename Payload>
+struct move_assign<Type, Payload, false> : copy_assign<Type, Payload>
+{
+    using copy_assign<Type, Payload>::copy_assign;
+
+    move_assign(const move_assign &) = default;
+    move_assign(move_assign &&) = default;
+    move_assign & operator=(const move_assign &) = default;
+
+    ZPP_MAYBE_CONSTEXPR20
+    move_assign & operator=(move_assign && other) noexcept(
+        std::is_nothrow_move_constructible_v<Type> &&
+            std::is_nothrow_move_assignable_v<Type>)
+    {
+        this->assign_from(std::move(other));
+        return *this;
+    }
+};
+
+/**
+ * Returns the result of calling the given function with the given
+ * arguments as the given maybe type, which holds no value if the
+ * function returns void.
+ */
+template <typename Result, typename Function, typename... Arguments>
+constexpr Result invoke_into(Function && function, Arguments &&... arguments)
+{
+    if constexpr (std::is_void_v<typename Result::type>) {
+        std::forward<Function>(function)(
+            std::forward<Arguments>(arguments)...);
+        return Result(std::in_place);
+    } else {
+        return Result(std::in_place,
+                      std::forward<Function>(function)(
+                          std::forward<Arguments>(arguments)...));
+    }
+}
+} // namespace maybe_detail
+
+/**
+ * Represents a value-or-error object.
+ * An object of this type may have a value stored inside or an error.
+ * The error is represented as zpp::error, and can be queried accessed
+ * using the 'error' member function.
+ * Example:
+ * ~~~
+ * // After defining my_error and the category of it as described
+ * // in the sample above for the error class.
+ *
+ * // Change this value to observe different behavior.
+ * bool is_success = true;
+ *
+ * // Example of using 'maybe'.
+ * zpp::maybe<int> foo(bool value)
+ * {
+ *     if (!value) {
+ *         // Fail with error code.
+ *         return my_error::something_bad;
+ *     }
+ *
+ *     // Success
+ *     return 1337;
+ * }
+ *
+ * // Example of using plain error code.
+ * zpp::error bar(bool value)
+ * {
+ *     if (!value) {
+ *         return my_error::something_really_bad;
+ *     }
+ * 
+ *     return my_error::success;
+ * }
+ *
+ * // Call foo and check error.
+ * void baz1()
+ * {
+ *     if (auto result = foo(is_success)) {
+ *         // Success path.
+ *         std::cout << "Success path: value is '"
+ *             << result.value() << "'\n";
+ *     } else {
+ *         // Error path.
+ *         std::cout << "Error path: error is '"
+ *             << result.error().code() << "', '"
+ *             << result.error().message() << "'\n";
+ *     }
+ * }
+ *
+ * // Call bar and check error.
+ * void baz2()
+ * {
+ *     if (auto error = bar(is_success); !error) {
+ *         // Error path.
+ *         std::cout << "Error path: error is '"
+ *             << error.code() << "', '"
+ *             << error.message() << "'\n";
+ *     } else {
+ *         // Success path.
+ *         std::cout << "Success path: code is '"
+ *             << error.code() << "'\n";
+ *     }
+ * }
+ * ~~~
+ * An optional payload type may be given, in which case the error is a
+ * 'zpp::basic_error' of that payload, see 'zpp::basic_error'.
+ */
+template <typename Type, typename Payload>
+class maybe : private maybe_detail::move_assign<Type, Payload>
+{
+public:
+    /**
+     * The base class.
+     */
+    using base = maybe_detail::move_assign<Type, Payload>;
+
+    /**
+     * The type of value.
+     */
+    using type = Type;
+
+    /**
+     * The type of the error payload, void if there is none.
+     */
+    using payload_type = Payload;
+
+    /**
+     * Alias to the error type.
+     */
+    using error_type = typename maybe_detail::error_body<Payload>::error_type;
+
+    /**
+     * Disable default construction.
+     */
+    maybe() = delete;
+
+    /**
+     * Constructs a maybe that holds a value, constructed from
+     * the given value.
+     */
+    template <
+        typename From = Type,
+        typename = std::enable_if_t<
+            std::is_constructible_v<Type, From &&> &&
+            !std::is_same_v<std::remove_cv_t<std::remove_reference_t<From>>,
+                            maybe> &&
+            !std::is_same_v<std::remove_cv_t<std::remove_reference_t<From>>,
+                            error_type> &&
+            !std::is_same_v<std::remove_cv_t<std::remove_reference_t<From>>,
+                            std::in_place_t>>>
+    constexpr maybe(From && value) noexcept(
+        std::is_nothrow_constructible_v<Type, From &&>) :
+        base(std::in_place, std::forward<From>(value))
+    {
+    }
+
+    /**
+     * Constructs a maybe that holds a value, constructed in place
+     * from the given arguments.
+     */
+    template <typename... Arguments,
+              typename = std::enable_if_t<
+                  std::is_constructible_v<Type, Arguments &&...>>>
+    constexpr explicit maybe(std::in_place_t,
+                             Arguments &&... arguments) noexcept(
+        std::is_nothrow_constructible_v<Type, Arguments &&...>) :
+        base(std::in_place, std::forward<Arguments>(arguments)...)
+    {
+    }
+
+    /**
+     * Constructs a maybe that holds an error.
+     */
+    constexpr maybe(const error_type & error) noexcept : base(error)
+    {
+    }
+
+    /**
+     * Constructs a maybe that holds an error, from an error of a
+     * different payload type. A payload that is not of this maybe is
+     * dropped, and a missing payload is value initialized.
+     */
+    template <typename Other,
+              typename = std::enable_if_t<
+                  std::is_base_of_v<error_detail::error, Other> &&
+                  !std::is_same_v<Other, error_type>>>
+    constexpr maybe(const Other & error) noexcept :
+        base(error_type(static_cast<const error_detail::error &>(error)))
+    {
+    }
+
+    /**
+     * Constructs a maybe that holds an error, from an error code
+     * enumeration.
+     */
+    template <typename ErrorCode,
+              typename = std::enable_if_t<
+                  std::is_enum_v<ErrorCode> &&
+                  !std::is_constructible_v<Type, ErrorCode>>>
+    constexpr maybe(ErrorCode error_code ZPP_MAYBE_SAMPLE_LOCATION_PARAMETER) :
+        base(error_type(error_detail::error(
+            error_code ZPP_MAYBE_SAMPLE_LOCATION_ARGUMENT)))
+    {
+    }
+
+    /**
+     * Destroys the current value or error, and constructs a value in
+     * place from the given arguments. Returns the new value.
+     */
+    template <typename... Arguments>
+    Type & emplace(Arguments &&... arguments) noexcept(
+        std::is_nothrow_constructible_v<Type, Arguments &&...>)
+    {
+        this->emplace_value(std::forward<Arguments>(arguments)...);
+        return this->m_value;
+    }
+
+    /**
+     * Returns the stored error.
+     * The error is a small trivially copyable object encoded in
+     * the maybe storage, hence it is returned by value.
+     * The behavior is undefined if the object has a stored value.
+     */
+    constexpr error_type error() const noexcept
+    {
+        return this->m_error.to_error(this->m_category);
+    }
+
+    /**
+     * Returns the stored value.
+     * The behavior is undefined if the object has a stored error.
+     */
+    constexpr Type & value() & noexcept
+    {
+        return this->m_value;
+    }
+
+    /**
+     * Returns the stored value.
+     * The behavior is undefined if the object has a stored error.
+     */
+    constexpr const Type & value() const & noexcept
+    {
+        return this->m_value;
+    }
+
+    /**
+     * Returns the stored value.
+     * The behavior is undefined if the object has a stored error.
+     */
+    constexpr Type && value() && noexcept
+    {
+        return std::move(this->m_value);
+    }
+
+    /**
+     * Returns the stored value.
+     * The behavior is undefined if the object has a stored error.
+     */
+    constexpr const Type && value() const && noexcept
+    {
+        return std::move(this->m_value);
+    }
+
+    /**
+     * Returns false if there is a stored error, else, there
+     * is a stored value and the return value is true.
+     */
+    constexpr explicit operator bool() const noexcept
+    {
+        return !this->m_category;
+    }
+
+    /**
+     * Returns the stored value if exists, otherwise returns the given
+     * default value.
+     */
+    template <typename Default>
+    constexpr Type value_or(Default && default_value) const &
+    {
+        if (!this->m_category) {
+            return this->m_value;
+        }
+        return static_cast<Type>(std::forward<Default>(default_value));
+    }
+
+    /**
+     * Returns the stored value if exists, otherwise returns the given
+     * default value.
+     */
+    template <typename Default>
+    constexpr Type value_or(Default && default_value) &&
+    {
+        if (!this->m_category) {
+            return std::move(this->m_value);
+        }
+        return static_cast<Type>(std::forward<Default>(default_value));
+    }
+
+    /**
+     * Calls the given function with the stored value, which must
+     * return a maybe, and returns its result. If there is a stored
+     * error, returns the error without calling the function.
+     */
+    template <typename Function>
+    constexpr auto and_then(Function && function) &
+    {
+        using result =
+            std::decay_t<decltype(std::forward<Function>(function)(
+                this->m_value))>;
+        if (!this->m_category) {
+            return std::forward<Function>(function)(this->m_value);
+        }
+        return result(error());
+    }
+
+    /**
+     * Calls the given function with the stored value, which must
+     * return a maybe, and returns its result. If there is a stored
+     * error, returns the error without calling the function.
+     */
+    template <typename Function>
+    constexpr auto and_then(Function && function) const &
+    {
+        using result =
+            std::decay_t<decltype(std::forward<Function>(function)(
+                this->m_value))>;
+        if (!this->m_category) {
+            return std::forward<Function>(function)(this->m_value);
+        }
+        return result(error());
+    }
+
+    /**
+     * Calls the given function with the stored value, which must
+     * return a maybe, and returns its result. If there is a stored
+     * error, returns the error without calling the function.
+     */
+    template <typename Function>
+    constexpr auto and_then(Function && function) &&
+    {
+        using result =
+            std::decay_t<decltype(std::forward<Function>(function)(
+                std::move(this->m_value)))>;
+        if (!this->m_category) {
+            return std::forward<Function>(function)(std::move(this->m_value));
+        }
+        return result(error());
+    }
+
+    /**
+     * Calls the given function with the stored value, which must
+     * return a maybe, and returns its result. If there is a stored
+     * error, returns the error without calling the function.
+     */
+    template <typename Function>
+    constexpr auto and_then(Function && function) const &&
+    {
+        using result =
+            std::decay_t<decltype(std::forward<Function>(function)(
+                std::move(this->m_value)))>;
+        if (!this->m_category) {
+            return std::forward<Function>(function)(std::move(this->m_value));
+        }
+        return result(error());
+    }
+
+    /**
+     * Returns a maybe holding the result of calling the given
+     * function with the stored value. If there is a stored error,
+     * returns the error without calling the function.
+     */
+    template <typename Function>
+    constexpr auto transform(Function && function) &
+    {
+        using result = maybe<std::decay_t<decltype(
+            std::forward<Function>(function)(this->m_value))>,
+                           Payload>;
+        if (!this->m_category) {
+            return maybe_detail::invoke_into<result>(
+                std::forward<Function>(function), this->m_value);
+        }
+        return result(error());
+    }
+
+    /**
+     * Returns a maybe holding the result of calling the given
+     * function with the stored value. If there is a stored error,
+     * returns the error without calling the function.
+     */
+    template <typename Function>
+    constexpr auto transform(Function && function) const &
+    {
+        using result = maybe<std::decay_t<decltype(
+            std::forward<Function>(function)(this->m_value))>,
+                           Payload>;
+        if (!this->m_category) {
+            return maybe_detail::invoke_into<result>(
+                std::forward<Function>(function), this->m_value);
+        }
+        return result(error());
+    }
+
+    /**
+     * Returns a maybe holding the result of calling the given
+     * function with the stored value. If there is a stored error,
+     * returns the error without calling the function.
+     */
+    template <typename Function>
+    constexpr auto transform(Function && function) &&
+    {
+        using result = maybe<std::decay_t<decltype(
+            std::forward<Function>(function)(std::move(this->m_value)))>,
+                           Payload>;
+        if (!this->m_category) {
+            return maybe_detail::invoke_into<result>(
+                std::forward<Function>(function), std::move(this->m_value));
+        }
+        return result(error());
+    }
+
+    /**
+     * Returns a maybe holding the result of calling the given
+     * function with the stored value. If there is a stored error,
+     * returns the error without calling the function.
+     */
+    template <typename Function>
+    constexpr auto transform(Function && function) const &&
+    {
+        using result = maybe<std::decay_t<decltype(
+            std::forward<Function>(function)(std::move(this->m_value)))>,
+                           Payload>;
+        if (!this->m_category) {
+            return maybe_detail::invoke_into<result>(
+                std::forward<Function>(function), std::move(this->m_value));
+        }
+        return result(error());
+    }
+
+    /**
+     * Returns a maybe holding the stored value, or the error
+     * returned from calling the given function with the stored error.
+     */
+    template <typename Function>
+    constexpr maybe transform_error(Function && function) const &
+    {
+        if (!this->m_category) {
+            return maybe(std::in_place, this->m_value);
+        }
+        return maybe(
+            error_type(std::forward<Function>(function)(error())));
+    }
+
+    /**
+     * Returns a maybe holding the stored value, or the error
+     * returned from calling the given function with the stored error.
+     */
+    template <typename Function>
+    constexpr maybe transform_error(Function && function) &&
+    {
+        if (!this->m_category) {
+            return maybe(std::in_place, std::move(this->m_value));
+        }
+        return maybe(
+            error_type(std::forward<Function>(function)(error())));
+    }
+
+    /**
+     * Returns a maybe holding the stored value, or the result of
+     * calling the given function with the stored error, which must
+     * return a maybe of the same value type.
+     */
+    template <typename Function>
+    constexpr maybe or_else(Function && function) const &
+    {
+        if (!this->m_category) {
+            return maybe(std::in_place, this->m_value);
+        }
+        return std::forward<Function>(function)(error());
+    }
+
+    /**
+     * Returns a maybe holding the stored value, or the result of
+     * calling the given function with the stored error, which must
+     * return a maybe of the same value type.
+     */
+    template <typename Function>
+    constexpr maybe or_else(Function && function) &&
+    {
+        if (!this->m_category) {
+            return maybe(std::in_place, std::move(this->m_value));
+        }
+        return std::forward<Function>(function)(error());
+    }
+
+    /**
+     * Records the stored error, if any, along with the location of
+     * the caller into the error trace of the calling thread, and
+     * returns this object. Does nothing unless 'ZPP_MAYBE_TRACE'
+     * is enabled.
+     */
+    constexpr const maybe &
+    trace([[maybe_unused]] const trace_location & location =
+              trace_location::current()) const & noexcept
+    {
+#if ZPP_MAYBE_TRACE
+        if (this->m_category) ZPP_MAYBE_UNLIKELY {
+            maybe_detail::trace(error(), location);
+        }
+#endif
+        return *this;
+    }
+
+    /**
+     * Records the stored error, if any, along with the location of
+     * the caller into the error trace of the calling thread, and
+     * returns this object. Does nothing unless 'ZPP_MAYBE_TRACE'
+     * is enabled.
+     */
+    constexpr maybe &&
+    trace([[maybe_unused]] const trace_location & location =
+              trace_location::current()) && noexcept
+    {
+#if ZPP_MAYBE_TRACE
+        if (this->m_category) ZPP_MAYBE_UNLIKELY {
+            maybe_detail::trace(error(), location);
+        }
+#endif
+        return std::move(*this);
+    }
+};
+
+/**
+ * Represents the success of an operation that has no value, or the
+ * error that prevented it. It is stored as the error code, the payload
+ * if there is one, and the encoded error category which is null on
+ * success, like 'zpp::error' itself.
+ */
+template <typename Payload>
+class maybe<void, Payload>
+{
+public:
+    /**
+     * The type of value.
+     */
+    using type = void;
+
+    /**
+     * The type of the error payload, void if there is none.
+     */
+    using payload_type = Payload;
+
+    /**
+     * Alias to the error type.
+     */
+    using error_type = typename maybe_detail::error_body<Payload>::error_type;
+
+    /**
+     * Constructs a maybe that indicates success.
+     */
+    constexpr maybe() noexcept = default;
+
+    /**
+     * Constructs a maybe that indicates success.
+     */
+    constexpr explicit maybe(std::in_place_t) noexcept
+    {
+    }
+
+    /**
+     * Constructs a maybe that holds an error, or that indicates success
+     * if the error is the success code of its category.
+     */
+    constexpr maybe(const error_type & error) noexcept :
+        m_error(maybe_detail::error_body<Payload>::from(error)),
+        m_category(error ? error_detail::error::encoded_category_type{}
+                         : error.encoded_category())
+    {
+    }
+
+    /**
+     * Constructs a maybe that holds an error, from an error of a
+     * different payload type. A payload that is not of this maybe is
+     * dropped, and a missing payload is value initialized.
+     */
+    template <typename Other,
+              typename = std::enable_if_t<
+                  std::is_base_of_v<error_detail::error, Other> &&
+                  !std::is_same_v<Other, error_type>>>
+    constexpr maybe(const Other & error) noexcept :
+        maybe(error_type(static_cast<const error_detail::error &>(error)))
+    {
+    }
+
+    /**
+     * Constructs a maybe that holds an error, from an error code
+     * enumeration.
+     */
+    template <typename ErrorCode,
+              typename = std::enable_if_t<std::is_enum_v<ErrorCode>>>
+    constexpr maybe(ErrorCode error_code ZPP_MAYBE_SAMPLE_LOCATION_PARAMETER) :
+        maybe(error_type(error_detail::error(
+            error_code ZPP_MAYBE_SAMPLE_LOCATION_ARGUMENT)))
+    {
+    }
+
+    /**
+     * Discards the current error, if any, and indicates success.
+     */
+    constexpr void emplace() noexcept
+    {
+        m_category = {};
+    }
+
+    /**
+     * Returns the stored error.
+     * The behavior is undefined if the object indicates success.
+     */
+    constexpr error_type error() const noexcept
+    {
+        return m_error.to_error(m_category);
+    }
+
+    /**
+     * Does nothing, allows generic code to treat all maybe objects
+     * alike.
+     */
+    constexpr void value() const noexcept
+    {
+    }
+
+    /**
+     * Returns false if there is a stored error, else, the object
+     * indicates success and the return value is true.
+     */
+    constexpr explicit operator bool() const noexcept
+    {
+        return !m_category;
+    }
+
+    /**
+     * Calls the given function, which must return a maybe, and returns
+     * its result. If there is a stored error, returns the error without
+     * calling the function.
+     */
+    template <typename Function>
+    constexpr auto and_then(Function && function) const
+    {
+        using result =
+            std::decay_t<decltype(std::forward<Function>(function)())>;
+        if (!m_category) {
+            return std::forward<Function>(function)();
+        }
+        return result(error());
+    }
+
+    /**
+     * Returns a maybe holding the result of calling the given
+     * function. If there is a stored error, returns the error without
+     * calling the function.
+     */
+    template <typename Function>
+    constexpr auto transform(Function && function) const
+    {
+        using result = maybe<
+            std::decay_t<decltype(std::forward<Function>(function)())>,
+            Payload>;
+        if (!m_category) {
+            return maybe_detail::invoke_into<result>(
+                std::forward<Function>(function));
+        }
+        return result(error());
+    }
+
+    /**
+     * Returns a maybe that indicates success, or holds the error
+     * returned from calling the given function with the stored error.
+     */
+    template <typename Function>
+    constexpr maybe transform_error(Function && function) const
+    {
+        if (!m_category) {
+            return maybe();
+        }
+        return maybe(
+            error_type(std::forward<Function>(function)(error())));
+    }
+
+    /**
+     * Returns a maybe that indicates success, or the result of calling
+     * the given function with the stored error, which must return a
+     * maybe of void.
+     */
+    template <typename Function>
+    constexpr maybe or_else(Function && function) const
+    {
+        if (!m_category) {
+            return maybe();
+        }
+        return std::forward<Function>(function)(error());
+    }
+
+    /**
+     * Records the stored error, if any, along with the location of
+     * the caller into the error trace of the calling thread, and
+     * returns this object. Does nothing unless 'ZPP_MAYBE_TRACE'
+     * is enabled.
+     */
+    constexpr const maybe &
+    trace([[maybe_unused]] const trace_location & location =
+              trace_location::current()) const & noexcept
+    {
+#if ZPP_MAYBE_TRACE
+        if (m_category) ZPP_MAYBE_UNLIKELY {
+            maybe_detail::trace(error(), location);
+        }
+#endif
+        return *this;
+    }
+
+    /**
+     * Records the stored error, if any, along with the location of
+     * the caller into the error trace of the calling thread, and
+     * returns this object. Does nothing unless 'ZPP_MAYBE_TRACE'
+     * is enabled.
+     */
+    constexpr maybe &&
+    trace([[maybe_unused]] const trace_location & location =
+              trace_location::current()) && noexcept
+    {
+#if ZPP_MAYBE_TRACE
+        if (m_category) ZPP_MAYBE_UNLIKELY {
+            maybe_detail::trace(error(), location);
+        }
+#endif
+        return std::move(*this);
+    }
+
+private:
+    /**
+     * The error code and payload, meaningful only if there is a
+     * stored error.
+     */
+    maybe_detail::error_body<Payload> m_error{};
+
+    /**
+     * The encoded error category, null on success.
+     */
+    error_detail::error::encoded_category_type m_category{};
+};
+
+/**
+ * Represents a reference to a value, or the error that prevented
+ * producing it. It is stored as a maybe of a pointer, so the reference
+ * costs no more than a pointer, and the referred value is never copied.
+ * A maybe of a reference rebinds on assignment, and cannot be bound to
+ * a temporary.
+ */
+template <typename Type, typename Payload>
+class maybe<Type &, Payload>
+{
+public:
+    /**
+     * The type of value.
+     */
+    using type = Type &;
+
+    /**
+     * The type of the error payload, void if there is none.
+     */
+    using payload_type = Payload;
+
+    /**
+     * Alias to the error type.
+     */
+    using error_type = typename maybe_detail::error_body<Payload>::error_type;
+
+    /**
+     * Disable default construction.
+     */
+    maybe() = delete;
+
+    /**
+     * Constructs a maybe that refers to the given value.
+     */
+    constexpr maybe(Type & value) noexcept : m_pointer(std::addressof(value))
+    {
+    }
+
+    /**
+     * Disables binding to temporaries.
+     */
+    maybe(const Type &&) = delete;
+
+    /**
+     * Constructs a maybe that holds an error.
+     */
+    constexpr maybe(const error_type & error) noexcept : m_pointer(error)
+    {
+    }
+
+    /**
+     * Constructs a maybe that holds an error, from an error of a
+     * different payload type. A payload that is not of this maybe is
+     * dropped, and a missing payload is value initialized.
+     */
+    template <typename Other,
+              typename = std::enable_if_t<
+                  std::is_base_of_v<error_detail::error, Other> &&
+                  !std::is_same_v<Other, error_type>>>
+    constexpr maybe(const Other & error) noexcept :
+        m_pointer(error_type(static_cast<const error_detail::error &>(error)))
+    {
+    }
+
+    /**
+     * Constructs a maybe that holds an error, from an error code
+     * enumeration.
+     */
+    template <typename ErrorCode,
+              typename = std::enable_if_t<
+                  std::is_enum_v<ErrorCode> &&
+                  !std::is_same_v<std::remove_cv_t<Type>, ErrorCode>>>
+    constexpr maybe(ErrorCode error_code ZPP_MAYBE_SAMPLE_LOCATION_PARAMETER) :
+        m_pointer(error_type(error_detail::error(
+            error_code ZPP_MAYBE_SAMPLE_LOCATION_ARGUMENT)))
+    {
+    }
+
+    /**
+     * Returns the stored error.
+     * The behavior is undefined if the object refers to a value.
+     */
+    constexpr error_type error() const noexcept
+    {
+        return m_pointer.error();
+    }
+
+    /**
+     * Returns the referred value.
+     * The behavior is undefined if the object has a stored error.
+     */
+    constexpr Type & value() const noexcept
+    {
+        return *m_pointer.value();
+    }
+
+    /**
+     * Returns false if there is a stored error, else, the object
+     * refers to a value and the return value is true.
+     */
+    constexpr explicit operator bool() const noexcept
+    {
+        return static_cast<bool>(m_pointer);
+    }
+
+    /**
+     * Returns the referred value if exists, otherwise returns the
+     * given default value.
+     */
+    constexpr Type & value_or(Type & default_value) const noexcept
+    {
+        if (m_pointer) {
+            return *m_pointer.value();
+        }
+        return default_value;
+    }
+
+    /**
+     * Calls the given function with the referred value, which must
+     * return a maybe, and returns its result. If there is a stored
+     * error, returns the error without calling the function.
+     */
+    template <typename Function>
+    constexpr auto and_then(Function && function) const
+    {
+        using result =
+            std::decay_t<decltype(std::forward<Function>(function)(
+                std::declval<Type &>()))>;
+        if (m_pointer) {
+            return std::forward<Function>(function)(*m_pointer.value());
+        }
+        return result(error());
+    }
+
+    /**
+     * Returns a maybe holding the result of calling the given
+     * function with the referred value. If there is a stored error,
+     * returns the error without calling the function.
+     */
+    template <typename Function>
+    constexpr auto transform(Function && function) const
+    {
+        using result = maybe<std::decay_t<decltype(
+                                 std::forward<Function>(function)(
+                                     std::declval<Type &>()))>,
+                             Payload>;
+        if (m_pointer) {
+            return maybe_detail::invoke_into<result>(
+                std::forward<Function>(function), *m_pointer.value());
+        }
+        return result(error());
+    }
+
+    /**
+     * Returns a maybe referring to the value, or holding the error
+     * returned from calling the given function with the stored error.
+     */
+    template <typename Function>
+    constexpr maybe transform_error(Function && function) const
+    {
+        if (m_pointer) {
+            return *this;
+        }
+        return maybe(
+            error_type(std::forward<Function>(function)(error())));
+    }
+
+    /**
+     * Returns a maybe referring to the value, or the result of calling
+     * the given function with the stored error, which must return a
+     * maybe of the same reference type.
+     */
+    template <typename Function>
+    constexpr maybe or_else(Function && function) const
+    {
+        if (m_pointer) {
+            return *this;
+        }
+        return std::forward<Function>(function)(error());
+    }
+
+    /**
+     * Records the stored error, if any, along with the location of
+     * the caller into the error trace of the calling thread, and
+     * returns this object. Does nothing unless 'ZPP_MAYBE_TRACE'
+     * is enabled.
+     */
+    constexpr const maybe &
+    trace([[maybe_unused]] const trace_location & location =
+              trace_location::current()) const & noexcept
+    {
+        m_pointer.trace(location);
+        return *this;
+    }
+
+    /**
+     * Records the stored error, if any, along with the location of
+     * the caller into the error trace of the calling thread, and
+     * returns this object. Does nothing unless 'ZPP_MAYBE_TRACE'
+     * is enabled.
+     */
+    constexpr maybe &&
+    trace([[maybe_unused]] const trace_location & location =
+              trace_location::current()) && noexcept
+    {
+        m_pointer.trace(location);
+        return std::move(*this);
+    }
+
+private:
+    /**
+     * The pointer to the referred value, or the error.
+     */
+    maybe<Type *, Payload> m_pointer;
+};
+
+/**
+ * Introduce error here instead of before 'maybe'.
+ */
+using error = error_detail::error;
+
+/**
+ * Introduce the error with a payload.
+ */
+template <typename Payload>
+using basic_error = error_detail::basic_error<Payload>;
+
+/**
+ * Registers the given error category in the category registry, so that
+ * errors carrying its identifier, such as errors that are received from
+ * another process, map back to it. Returns false if the registry is
+ * full or a category with the same identifier but a different name is
+ * already registered.
+ */
+inline bool register_error_category(const error_category & category) noexcept
+{
+    return error_detail::category_registry::add(category);
+}
+
+/**
+ * Registers the error category of the given error code enumeration,
+ * as above.
+ */
+template <typename ErrorCode>
+bool register_error_category() noexcept
+{
+    return register_error_category(zpp::category<ErrorCode>());
+}
+
+/**
+ * Returns the registered error category of the given identifier, or
+ * null if there is none.
+ */
+inline const error_category * find_error_category(std::uint32_t id) noexcept
+{
+    return error_detail::category_registry::find(id);
+}
+
+/**
+ * A set of error codes of a single category, backed by a bitmask. Codes
+ * must be in the range [0, Bits), membership tests are branch free.
+ * Example:
+ * ~~~
+ * constexpr zpp::error_set<my_error> retryable{
+ *     my_error::something_bad,
+ *     my_error::something_really_bad,
+ * };
+ *
+ * if (retryable.contains(error)) {
+ *     // Retry.
+ * }
+ * ~~~
+ */
+template <typename ErrorCode, std::size_t Bits = 64>
+class error_set
+{
+public:
+    static_assert(std::is_enum_v<ErrorCode>,
+                  "The error code must be an enumeration.");
+    static_assert(Bits && !(Bits % 64),
+                  "The number of bits must be a multiple of 64.");
+
+    /**
+     * The number of words in the bitmask.
+     */
+    static constexpr std::size_t words = Bits / 64;
+
+    /**
+     * Constructs an empty set.
+     */
+    constexpr error_set() = default;
+
+    /**
+     * Constructs a set of the given codes.
+     */
+    constexpr error_set(std::initializer_list<ErrorCode> codes) noexcept
+    {
+        for (auto code : codes) {
+            insert(code);
+        }
+    }
+
+    /**
+     * Adds the given code to the set.
+     */
+    constexpr error_set & insert(ErrorCode code) noexcept
+    {
+        auto value = std::uint32_t(code);
+        m_mask[(value / 64) % words] |= std::uint64_t(value < Bits)
+                                        << (value % 64);
+        return *this;
+    }
+
+    /**
+     * Removes the given code from the set.
+     */
+    constexpr error_set & erase(ErrorCode code) noexcept
+    {
+        auto value = std::uint32_t(code);
+        m_mask[(value / 64) % words] &=
+            ~(std::uint64_t(value < Bits) << (value % 64));
+        return *this;
+    }
+
+    /**
+     * Returns true if the set contains the given code, else false.
+     */
+    constexpr bool contains(ErrorCode code) const noexcept
+    {
+        return test(std::uint32_t(code));
+    }
+
+    /**
+     * Returns true if the error is of the category of the set and its
+     * code is in the set, else false.
+     */
+    constexpr bool contains(const error & other) const noexcept
+    {
+        const auto & category = zpp::category<ErrorCode>();
+#if ZPP_MAYBE_COMPACT_ERROR
+        bool same_category = other.category_id() == category.id();
+#else
+        bool same_category =
+            (std::addressof(other.category()) == std::addressof(category)) |
+            (other.category_id() == category.id());
+#endif
+        return same_category & test(std::uint32_t(other.code()));
+    }
+
+private:
+    /**
+     * Returns true if the given code is in the set.
+     */
+    constexpr bool test(std::uint32_t value) const noexcept
+    {
+        return (value < Bits) &
+               bool((m_mask[(value / 64) % words] >> (value % 64)) & 1);
+    }
+
+    /**
+     * The bitmask of codes.
+     */
+    std::uint64_t m_mask[words]{};
+};
+
+#if ZPP_MAYBE_COUNTERS
+/**
+ * Introduce the error count.
+ */
+using error_count = error_detail::error_count;
+
+/**
+ * Writes the counts of up to 'size' distinct category and code pairs of
+ * the failing errors constructed so far, summed over all threads, into
+ * the given array. Returns the number of pairs that were written.
+ * Example:
+ * ~~~
+ * zpp::error_count counts[64];
+ * auto size = zpp::snapshot_error_counts(counts, std::size(counts));
+ * for (std::size_t index = 0; index < size; ++index) {
+ *     std::cout << counts[index].category->name() << ' '
+ *         << counts[index].code << ": " << counts[index].count << '\n';
+ * }
+ * ~~~
+ */
+inline std::size_t snapshot_error_counts(error_count * counts,
+                                         std::size_t size) noexcept
+{
+    return error_detail::error_counters::snapshot(counts, size);
+}
+
+/**
+ * Returns the number of failing errors that were not counted, since
+ * the counters of their thread had no free slot.
+ */
+inline std::uint64_t dropped_error_counts() noexcept
+{
+    return error_detail::error_counters::dropped();
+}
+#endif
+
+#if ZPP_MAYBE_SAMPLING
+/**
+ * Introduce the error sample.
+ */
+using error_sample = error_detail::error_sample;
+
+/**
+ * Sets the sampling period of the given category, one of every 'period'
+ * failing errors of each of its codes is captured on each thread, and
+ * zero disables sampling of the category. The first failing error of
+ * each code on each thread is sampled, and errors counted before the
+ * period was set restart their countdowns from the new period. Returns
+ * false if the periods of too many categories were set.
+ */
+inline bool set_error_sample_period(const error_category & category,
+                                    std::uint32_t period) noexcept
+{
+    return error_detail::error_samples::set_period(category, period);
+}
+
+/**
+ * Sets the sampling period of the category of the given error code
+ * enumeration, as above.
+ */
+template <typename ErrorCode,
+          typename = std::enable_if_t<std::is_enum_v<ErrorCode>>>
+bool set_error_sample_period(std::uint32_t period) noexcept
+{
+    return zpp::set_error_sample_period(zpp::category<ErrorCode>(), period);
+}
+
+/**
+ * Writes up to 'size' of the most recent samples of failing errors into
+ * the given array, in no particular order. Returns the number of samples
+ * that were written.
+ * Example:
+ * ~~~
+ * zpp::set_error_sample_period<my_error>(100);
+ *
+ * zpp::error_sample samples[64];
+ * auto size = zpp::snapshot_error_samples(samples, std::size(samples));
+ * for (std::size_t index = 0; index < size; ++index) {
+ *     std::cout << samples[index].category->name() << ' '
+ *         << samples[index].code << ": " << samples[index].file << ':'
+ *         << samples[index].line << ' ' << samples[index].function
+ *         << '\n';
+ * }
+ * ~~~
+ */
+inline std::size_t snapshot_error_samples(error_sample * samples,
+                                          std::size_t size) noexcept
+{
+    return error_detail::error_samples::snapshot(samples, size);
+}
+#endif
+
+#if ZPP_MAYBE_COMPACT_ERROR
+static_assert(sizeof(error) == sizeof(std::uint64_t),
+              "The compact error must fit in a single register.");
+static_assert(sizeof(maybe<int>) == sizeof(std::uint64_t),
+              "The compact 'maybe<int>' must fit in a single register.");
+static_assert(sizeof(maybe<std::uint64_t>) == 2 * sizeof(std::uint64_t),
+              "The compact 'maybe<std::uint64_t>' must fit in a register "
+              "pair.");
+static_assert(sizeof(maybe<int, std::uint32_t>) <=
+                  2 * sizeof(std::uint64_t),
+              "The compact 'maybe<int, std::uint32_t>' must fit in a "
+              "register pair.");
+#else
+static_assert(sizeof(maybe<std::uint64_t>) == sizeof(error),
+              "The 'maybe<std::uint64_t>' must not be larger than the "
+              "error.");
+#endif
+static_assert(sizeof(maybe<int>) == sizeof(error),
+              "The 'maybe<int>' must not be larger than the error.");
+static_assert(sizeof(maybe<void>) == sizeof(error),
+              "The 'maybe<void>' must not be larger than the error.");
+static_assert(sizeof(maybe<int &>) == sizeof(maybe<int *>),
+              "The 'maybe<int &>' must not be larger than 'maybe<int *>'.");
+
+namespace maybe_detail
+{
+/**
+ * Whether all of the given types are trivially copyable.
+ */
+template <typename... Types>
+inline constexpr bool all_trivially_copyable =
+    (std::is_trivially_copyable_v<Types> && ...);
+} // namespace maybe_detail
+
+static_assert(maybe_detail::all_trivially_copyable<
+                  error,
+                  error_detail::basic_error<std::uint32_t>,
+                  maybe<int>,
+                  maybe<std::uint64_t>,
+                  maybe<double>,
+                  maybe<int *>,
+                  maybe<int &>,
+                  maybe<void>,
+                  maybe<int, std::uint32_t>,
+                  maybe<void, std::uint32_t>>,
+              "Errors and maybe of trivially copyable types must be "
+              "trivially copyable, to be passed and returned in registers.");
+
+/**
+ * Whether objects of the given type may be relocated - moved to a new
+ * address and destroyed at the old one - by copying their bytes.
+ * Trivially copyable types are trivially relocatable, specialize this
+ * for other types that are known to be, such as types holding a
+ * pointer to owned memory.
+ */
+template <typename Type>
+struct is_trivially_relocatable
+    : std::bool_constant<std::is_trivially_copyable_v<Type>>
+{
+};
+
+/**
+ * A maybe is trivially relocatable if its value type is, since the
+ * error is trivially copyable.
+ */
+template <typename Type, typename Payload>
+struct is_trivially_relocatable<maybe<Type, Payload>>
+    : is_trivially_relocatable<Type>
+{
+};
+
+/**
+ * A maybe of void or of a reference is trivially relocatable, it holds
+ * no more than an error or a pointer.
+ */
+template <typename Payload>
+struct is_trivially_relocatable<maybe<void, Payload>> : std::true_type
+{
+};
+
+template <typename Type, typename Payload>
+struct is_trivially_relocatable<maybe<Type &, Payload>> : std::true_type
+{
+};
+
+/**
+ * Whether objects of the given type are trivially relocatable.
+ */
+template <typename Type>
+inline constexpr bool is_trivially_relocatable_v =
+    is_trivially_relocatable<Type>::value;
+
+/**
+ * Relocates the objects in the range [first, last) to the uninitialized
+ * memory starting at 'destination', leaving the source range
+ * uninitialized. Trivially relocatable types are relocated with a single
+ * memory copy, other types are move constructed into the destination,
+ * or copy constructed if their move constructor may throw, and the
+ * sources are destroyed after, in which case the ranges must not
+ * overlap. If a constructor throws, the constructed objects are
+ * destroyed and the source range is kept, holding the moved from
+ * objects if the type could not be copied.
+ * Returns the end of the destination range.
+ */
+template <typename Type>
+Type * relocate(Type * first, Type * last, Type * destination) noexcept(
+    is_trivially_relocatable_v<Type> ||
+    std::is_nothrow_move_constructible_v<Type>)
+{
+    if constexpr (is_trivially_relocatable_v<Type>) {
+        auto size = std::size_t(last - first);
+        if (size) {
+#if !ZPP_MAYBE_FREESTANDING
+            std::memmove(static_cast<void *>(destination),
+                         static_cast<const void *>(first),
+                         size * sizeof(Type));
+#else
+            __builtin_memmove(static_cast<void *>(destination),
+                              static_cast<const void *>(first),
+                              size * sizeof(Type));
+#endif
+        }
+        return destination + size;
+    } else {
+        // Construct every object before destroying any source, so that
+        // a throwing constructor can be rolled back.
+        auto constructed = destination;
+#if defined(__cpp_exceptions)
+        try {
+#endif
+            for (auto source = first; source != last;
+                 ++source, ++constructed) {
+                ::new (static_cast<void *>(constructed))
+                    Type(std::move_if_noexcept(*source));
+            }
+#if defined(__cpp_exceptions)
+        } catch (...) {
+            for (; destination != constructed; ++destination) {
+                destination->~Type();
+            }
+            throw;
+        }
+#endif
+        for (; first != last; ++first) {
+            first->~Type();
+        }
+        return constructed;
+    }
+}
+
+/**
+ * Relocates the object at 'source' to the uninitialized memory at
+ * 'destination', leaving the source uninitialized.
+ * Returns the relocated object.
+ */
+template <typename Type>
+Type * relocate_at(Type * source, Type * destination) noexcept(
+    is_trivially_relocatable_v<Type> ||
+    std::is_nothrow_move_constructible_v<Type>)
+{
+    relocate(source, source + 1, destination);
+    return std::launder(destination);
+}
+
+/**
+ * A fixed capacity list of errors, collecting up to 'Capacity' failures
+ * inline with no memory allocations. Failures beyond the capacity are
+ * only counted. This allows validating a whole input in one pass and
+ * reporting every failure, in environments where allocation is not
+ * possible.
+ * Example:
+ * ~~~
+ * zpp::error_list<8> validate(const frame & frame)
+ * {
+ *     zpp::error_list<8> errors;
+ *     errors.push(validate_header(frame.header));
+ *     for (auto & field : frame.fields) {
+ *         errors.push(validate_field(field));
+ *     }
+ *     return errors;
+ * }
+ *
+ * if (auto errors = validate(frame); !errors) {
+ *     for (auto & error : errors) {
+ *         log(error.message());
+ *     }
+ * }
+ * ~~~
+ */
+template <std::size_t Capacity>
+class error_list
+{
+public:
+    static_assert(Capacity > 0, "The capacity must not be zero.");
+
+    /**
+     * Constructs an empty error list.
+     */
+    constexpr error_list() noexcept
     {
     }
 
     /**
-     * Returns the error category.
+     * Records the given error if it indicates a failure, success
+     * errors are ignored, so that results may be pushed unconditionally.
+     * Returns false if the error was a failure that did not fit
+     * and was only counted, else true.
      */
-    const error_category & category() const
+    ZPP_MAYBE_CONSTEXPR20 bool push(const error & other) noexcept
     {
-        return *m_category;
+        if (other) {
+            return true;
+        }
+
+        if (m_size == Capacity) ZPP_MAYBE_UNLIKELY {
+            ++m_overflow;
+            return false;
+        }
+
+        maybe_detail::construct_value(m_storage.m_errors + m_size, other);
+        ++m_size;
+        return true;
     }
 
     /**
-     * Returns the error code.
+     * Records the error of the given maybe, if it holds an error.
+     * Returns false if the error did not fit and was only counted,
+     * else true.
      */
-    int code() const
+    template <typename Type, typename Payload>
+    ZPP_MAYBE_CONSTEXPR20 bool
+    push(const maybe<Type, Payload> & maybe) noexcept
     {
-        return m_code;
+        if (maybe) {
+            return true;
+        }
+        return push(maybe.error());
     }
 
     /**
-     * Returns the error message. Calling this on
-     * a success error is implementation defined according
-     * to the error category.
+     * Returns true if no failure was recorded, else false.
      */
-    std::string_view message() const
+    constexpr explicit operator bool() const noexcept
     {
-        return m_category->message(m_code);
+        return !m_size;
     }
 
     /**
-     * Returns true if the error indicates success, else false.
+     * Returns the number of stored errors.
      */
-    explicit operator bool() const
+    constexpr std::size_t size() const noexcept
     {
-        return m_category->success(m_code);
+        return m_size;
     }
 
     /**
-     * No error message value.
+     * Returns true if there are no stored errors.
      */
-    static constexpr std::string_view no_error{};
+    constexpr bool empty() const noexcept
+    {
+        return !m_size;
+    }
+
+    /**
+     * Returns the maximum number of stored errors.
+     */
+    static constexpr std::size_t capacity() noexcept
+    {
+        return Capacity;
+    }
+
+    /**
+     * Returns the number of failures that did not fit.
+     */
+    constexpr std::size_t overflow() const noexcept
+    {
+        return m_overflow;
+    }
+
+    /**
+     * Returns the total number of failures, stored or not.
+     */
+    constexpr std::size_t failures() const noexcept
+    {
+        return m_size + m_overflow;
+    }
+
+    /**
+     * Returns the first stored error.
+     * The behavior is undefined if there are no stored errors.
+     */
+    const error & front() const noexcept
+    {
+        return *begin();
+    }
+
+    /**
+     * Returns the beginning of the stored errors.
+     */
+    const error * begin() const noexcept
+    {
+        return std::launder(m_storage.m_errors);
+    }
+
+    /**
+     * Returns the end of the stored errors.
+     */
+    const error * end() const noexcept
+    {
+        return begin() + m_size;
+    }
+
+    /**
+     * Removes all errors and resets the overflow count.
+     */
+    constexpr void clear() noexcept
+    {
+        m_size = 0;
+        m_overflow = 0;
+    }
 
 private:
     /**
-     * The error category.
+     * Uninitialized storage for the errors.
      */
-    const error_category * m_category{};
+    union storage
+    {
+        constexpr storage() noexcept : m_empty()
+        {
+        }
+
+        char m_empty;
+        error m_errors[Capacity];
+    } m_storage;
 
     /**
-     * The error code.
+     * The number of stored errors.
+     */
+    std::size_t m_size{};
+
+    /**
+     * The number of failures that did not fit.
      */
-    int m_code{};
+    std::size_t m_overflow{};
 };
-} // namespace error_detail
 
 /**
- * Represents a value-or-error object.
- * An object of this type may have a value stored inside or an error.
- * The error is represented as zpp::error, and can be queried accessed
- * using the 'error' member function.
- * Example:
- * ~~~
- * // After defining my_error and the category of it as described
- * // in the sample above for the error class.
- *
- * // Change this value to observe different behavior.
- * bool is_success = true;
- *
- * // Example of using 'maybe'.
- * zpp::maybe<int> foo(bool value)
- * {
- *     if (!value) {
- *         // Fail with error code.
- *         return my_error::something_bad;
- *     }
- *
- *     // Success
- *     return 1337;
- * }
- *
- * // Example of using plain error code.
- * zpp::error bar(bool value)
- * {
- *     if (!value) {
- *         return my_error::something_really_bad;
- *     }
- * 
- *     return my_error::success;
- * }
- *
- * // Call foo and check error.
- * void baz1()
- * {
- *     if (auto result = foo(is_success)) {
- *         // Success path.
- *         std::cout << "Success path: value is '"
- *             << result.value() << "'\n";
- *     } else {
- *         // Error path.
- *         std::cout << "Error path: error is '"
- *             << result.error().code() << "', '"
- *             << result.error().message() << "'\n";
- *     }
- * }
- *
- * // Call bar and check error.
- * void baz2()
- * {
- *     if (auto error = bar(is_success); !error) {
- *         // Error path.
- *         std::cout << "Error path: error is '"
- *             << error.code() << "', '"
- *             << error.message() << "'\n";
- *     } else {
- *         // Success path.
- *         std::cout << "Success path: code is '"
- *             << error.code() << "'\n";
- *     }
- * }
- * ~~~
+ * Represents a value, or all the errors that prevented producing it,
+ * up to 'Capacity' of them. See 'error_list'.
  */
-template <typename Type>
-class maybe : private std::variant<Type, error_detail::error>
+template <typename Type, std::size_t Capacity>
+class maybe_all
 {
 public:
-    /**
-     * The base class.
-     */
-    using base = std::variant<Type, error_detail::error>;
-
     /**
      * The type of value.
      */
@@ -326,55 +4362,276 @@ public:
     using error_type = error_detail::error;
 
     /**
-     * Disable default construction.
+     * Constructs a maybe that holds a value, constructed from
+     * the given value.
      */
-    maybe() = delete;
+    template <
+        typename From = Type,
+        typename = std::enable_if_t<
+            std::is_constructible_v<maybe<Type>, From &&> &&
+            !std::is_same_v<std::remove_cv_t<std::remove_reference_t<From>>,
+                            maybe_all> &&
+            !std::is_same_v<std::remove_cv_t<std::remove_reference_t<From>>,
+                            error_list<Capacity>>>>
+    constexpr maybe_all(From && value) noexcept(
+        std::is_nothrow_constructible_v<maybe<Type>, From &&>) :
+        m_result(std::forward<From>(value))
+    {
+        if (!m_result) {
+            m_errors.push(m_result.error());
+        }
+    }
 
     /**
-     * Inherit base class constructors.
+     * Constructs a maybe that holds the given errors. An empty list
+     * indicates success, and holds a value initialized value, for which
+     * the type must be default constructible.
      */
-    using std::variant<Type, error_type>::variant;
+    constexpr maybe_all(const error_list<Capacity> & errors) noexcept(
+        !std::is_default_constructible_v<Type> ||
+        std::is_nothrow_default_constructible_v<Type>) :
+        m_result(from_errors(errors)), m_errors(errors)
+    {
+    }
 
     /**
-     * Returns the stored error.
+     * Returns false if there are stored errors, else, there
+     * is a stored value and the return value is true.
+     */
+    constexpr explicit operator bool() const noexcept
+    {
+        return bool(m_result);
+    }
+
+    /**
+     * Returns the first stored error.
      * The behavior is undefined if the object has a stored value.
      */
-    auto error() const
+    constexpr error_type error() const noexcept
+    {
+        return m_result.error();
+    }
+
+    /**
+     * Returns the stored errors, empty if there is a stored value.
+     */
+    constexpr const error_list<Capacity> & errors() const noexcept
     {
-        return *std::get_if<error_type>(this);
+        return m_errors;
     }
 
     /**
      * Returns the stored value.
      * The behavior is undefined if the object has a stored error.
      */
-    decltype(auto) value() &&
+    constexpr Type & value() & noexcept
     {
-        return std::move(*std::get_if<type>(this));
+        return m_result.value();
     }
 
     /**
      * Returns the stored value.
      * The behavior is undefined if the object has a stored error.
      */
-    decltype(auto) value() &
+    constexpr const Type & value() const & noexcept
     {
-        return *std::get_if<type>(this);
+        return m_result.value();
     }
 
     /**
-     * Returns false if there is a stored error, else, there
-     * is a stored value and the return value is true.
+     * Returns the stored value.
+     * The behavior is undefined if the object has a stored error.
+     */
+    constexpr Type && value() && noexcept
+    {
+        return std::move(m_result).value();
+    }
+
+    /**
+     * Returns the stored value or the first error as a maybe.
+     */
+    constexpr const maybe<Type> & result() const & noexcept
+    {
+        return m_result;
+    }
+
+    /**
+     * Returns the stored value or the first error as a maybe.
      */
-    explicit operator bool() const
+    constexpr maybe<Type> && result() && noexcept
     {
-        return (0 == this->index());
+        return std::move(m_result);
     }
+
+private:
+    /**
+     * Returns the first error of the list, or a value initialized value
+     * if it is empty. Without a default constructor there is no value to
+     * indicate success with, and an empty list terminates.
+     */
+    static constexpr maybe<Type>
+    from_errors(const error_list<Capacity> & errors)
+    {
+        if (errors.empty()) ZPP_MAYBE_UNLIKELY {
+            if constexpr (std::is_default_constructible_v<Type>) {
+                return maybe<Type>(Type());
+            } else {
+                std::terminate();
+            }
+        }
+        return errors.front();
+    }
+
+    /**
+     * The value, or the first error.
+     */
+    maybe<Type> m_result;
+
+    /**
+     * The errors.
+     */
+    error_list<Capacity> m_errors;
 };
 
+namespace maybe_detail
+{
 /**
- * Introduce error here instead of before 'maybe'.
+ * Returns the error of the given maybe, used by 'ZPP_TRY' to propagate
+ * errors. Marked cold to keep the error path out of the hot
+ * instruction stream. When tracing is enabled, the error is traced
+ * at the location of the caller.
  */
-using error = error_detail::error;
-
+#if ZPP_MAYBE_TRACE
+template <typename Maybe>
+ZPP_MAYBE_COLD constexpr auto
+propagate(const Maybe & maybe,
+          const trace_location & location =
+              trace_location::current()) noexcept
+{
+    trace(maybe.error(), location);
+    return maybe.error();
+}
+#else
+template <typename Maybe>
+ZPP_MAYBE_COLD constexpr auto propagate(const Maybe & maybe) noexcept
+{
+    return maybe.error();
+}
+#endif
+} // namespace maybe_detail
 } // namespace zpp
+
+/**
+ * Hashes errors by category identifier and code, consistent with the
+ * equality of errors.
+ */
+template <>
+struct std::hash<zpp::error>
+{
+    std::size_t operator()(const zpp::error & error) const noexcept
+    {
+        auto value = (std::uint64_t(error.category_id()) << 32) |
+                     std::uint32_t(error.code());
+        value ^= value >> 33;
+        value *= 0xff51afd7ed558ccd;
+        value ^= value >> 33;
+        return std::size_t(value);
+    }
+};
+
+/**
+ * Concatenates two tokens after expanding them.
+ */
+#define ZPP_MAYBE_CONCAT_IMPL(left, right) left##right
+#define ZPP_MAYBE_CONCAT(left, right) ZPP_MAYBE_CONCAT_IMPL(left, right)
+
+/**
+ * Expands to a number that is unique within the translation unit where
+ * supported, otherwise to the line number.
+ */
+#if defined(__COUNTER__)
+#define ZPP_MAYBE_UNIQUE __COUNTER__
+#else
+#define ZPP_MAYBE_UNIQUE __LINE__
+#endif
+
+/**
+ * Evaluates the given expression which results in a maybe, if it holds
+ * an error, returns the error from the enclosing function, otherwise,
+ * moves the value into the declared variable.
+ * Example:
+ * ~~~
+ * zpp::maybe<int> sum(std::string_view first, std::string_view second)
+ * {
+ *     ZPP_TRY(auto left, parse(first));
+ *     ZPP_TRY(auto right, parse(second));
+ *     return left + right;
+ * }
+ * ~~~
+ */
+#define ZPP_TRY(variable, ...)                                             \
+    ZPP_MAYBE_TRY_IMPL(ZPP_MAYBE_CONCAT(zpp_try_result_, ZPP_MAYBE_UNIQUE), \
+                       variable,                                           \
+                       __VA_ARGS__)
+
+/**
+ * The implementation of 'ZPP_TRY' using the given unique name.
+ */
+#define ZPP_MAYBE_TRY_IMPL(result, variable, ...)                          \
+    auto && result = (__VA_ARGS__);                                        \
+    if (!result) ZPP_MAYBE_UNLIKELY {                                      \
+        return ::zpp::maybe_detail::propagate(result);                     \
+    }                                                                      \
+    variable = std::forward<decltype(result)>(result).value()
+
+/**
+ * Evaluates the given expression which results in a maybe, if it holds
+ * an error, returns the error from the enclosing function, otherwise,
+ * discards the value, if any. Meant for 'zpp::maybe<void>'.
+ * Example:
+ * ~~~
+ * zpp::maybe<void> save(const settings & settings)
+ * {
+ *     ZPP_TRY_VOID(validate(settings));
+ *     ZPP_TRY_VOID(write(settings));
+ *     return {};
+ * }
+ * ~~~
+ */
+#define ZPP_TRY_VOID(...)                                                  \
+    ZPP_MAYBE_TRY_VOID_IMPL(                                               \
+        ZPP_MAYBE_CONCAT(zpp_try_result_, ZPP_MAYBE_UNIQUE), __VA_ARGS__)
+
+/**
+ * The implementation of 'ZPP_TRY_VOID' using the given unique name.
+ */
+#define ZPP_MAYBE_TRY_VOID_IMPL(result, ...)                               \
+    auto && result = (__VA_ARGS__);                                        \
+    if (!result) ZPP_MAYBE_UNLIKELY {                                      \
+        return ::zpp::maybe_detail::propagate(result);                     \
+    }                                                                      \
+    static_cast<void>(result)
+
+#if defined(__GNUC__) || defined(__clang__)
+/**
+ * Evaluates the given expression which results in a maybe, if it holds
+ * an error, returns the error from the enclosing function, otherwise,
+ * evaluates to the value.
+ * This uses statement expressions, a GNU extension.
+ * Example:
+ * ~~~
+ * zpp::maybe<int> sum(std::string_view first, std::string_view second)
+ * {
+ *     return ZPP_TRY_EXPR(parse(first)) + ZPP_TRY_EXPR(parse(second));
+ * }
+ * ~~~
+ */
+#define ZPP_TRY_EXPR(...)                                                  \
+    __extension__({                                                        \
+        auto && zpp_try_result = (__VA_ARGS__);                            \
+        if (!zpp_try_result) ZPP_MAYBE_UNLIKELY {                          \
+            return ::zpp::maybe_detail::propagate(zpp_try_result);         \
+        }                                                                  \
+        std::forward<decltype(zpp_try_result)>(zpp_try_result).value();   \
+    })
+#endif
@@ -0,0 +1,859 @@
+#pragma once
+#include "maybe.h"
+
+#if !defined(__cpp_impl_coroutine) || !__has_include(<coroutine>)
+#error "zpp/maybe_coroutine.h requires C++20 coroutines."
+#endif
+
+#include <coroutine>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <new>
+#include <optional>
+#include <type_traits>
+#include <utility>
+
+namespace zpp
+{
+/**
+ * The errors of maybe coroutines.
+ */
+enum class coroutine_error : int
+{
+    success = 0,
+    frame_allocation_failed = 1,
+    suspended = 2,
+    moved_from = 3,
+};
+
+/**
+ * The error category of maybe coroutines.
+ */
+template <>
+inline constexpr auto define_error_category<coroutine_error> =
+    make_error_category("zpp::coroutine_error",
+                        coroutine_error::success,
+                        {
+                            {coroutine_error::success, error::no_error},
+                            {coroutine_error::frame_allocation_failed,
+                             "Failed to allocate the coroutine frame."},
+                            {coroutine_error::suspended,
+                             "The task is waiting for an asynchronous event."},
+                            {coroutine_error::moved_from,
+                             "The task was moved from."},
+                        });
+
+/**
+ * A fixed size arena for coroutine frames, in which frames are bump
+ * allocated and released all at once using 'reset()'. When the arena is
+ * installed using 'zpp::frame_allocator_scope', the frames of maybe
+ * tasks never touch the global heap.
+ */
+template <std::size_t Size>
+class frame_arena
+{
+public:
+    /**
+     * Allocates the given number of bytes, returns null if the arena is
+     * exhausted.
+     */
+    void * allocate(std::size_t size, std::size_t alignment) noexcept
+    {
+        auto offset = (m_used + alignment - 1) & ~(alignment - 1);
+        if (offset > Size || Size - offset < size) ZPP_MAYBE_UNLIKELY {
+            return nullptr;
+        }
+        m_used = offset + size;
+        return m_buffer + offset;
+    }
+
+    /**
+     * Does nothing, the memory is released by 'reset()'.
+     */
+    void deallocate(void *, std::size_t, std::size_t) noexcept
+    {
+    }
+
+    /**
+     * Releases all allocations, no frame allocated from the arena may
+     * be alive.
+     */
+    void reset() noexcept
+    {
+        m_used = 0;
+    }
+
+    /**
+     * Returns the number of bytes in use.
+     */
+    std::size_t used() const noexcept
+    {
+        return m_used;
+    }
+
+private:
+    /**
+     * The arena memory.
+     */
+    alignas(std::max_align_t) unsigned char m_buffer[Size];
+
+    /**
+     * The number of bytes in use.
+     */
+    std::size_t m_used{};
+};
+
+template <typename Type>
+class maybe_task;
+
+/**
+ * Implementation details of maybe coroutines.
+ */
+namespace coroutine_detail
+{
+template <typename Type>
+class task_awaiter;
+
+/**
+ * Whether the given type is a maybe.
+ */
+template <typename Type>
+struct is_maybe : std::false_type
+{
+};
+
+template <typename Type, typename Payload>
+struct is_maybe<maybe<Type, Payload>> : std::true_type
+{
+};
+
+/**
+ * Stored after the coroutine frame, knows how to release it.
+ */
+struct frame_footer
+{
+    /**
+     * Releases the frame.
+     */
+    void (*deallocate)(void * allocator,
+                       void * frame,
+                       std::size_t size) noexcept;
+
+    /**
+     * The allocator, null for the global heap.
+     */
+    void * allocator;
+};
+
+/**
+ * The frame allocator of the calling thread.
+ */
+struct frame_allocator
+{
+    /**
+     * Allocates a frame, null for the global heap.
+     */
+    void * (*allocate)(void * allocator, std::size_t size) noexcept;
+
+    /**
+     * Releases a frame.
+     */
+    void (*deallocate)(void * allocator,
+                       void * frame,
+                       std::size_t size) noexcept;
+
+    /**
+     * The allocator.
+     */
+    void * allocator;
+};
+
+/**
+ * Returns the frame allocator of the calling thread.
+ */
+inline frame_allocator & current_frame_allocator() noexcept
+{
+    thread_local frame_allocator current{};
+    return current;
+}
+
+/**
+ * Releases a frame to the global heap.
+ */
+inline void global_deallocate(void *, void * frame, std::size_t) noexcept
+{
+    ::operator delete(frame);
+}
+
+/**
+ * The alignment of coroutine frames.
+ */
+inline constexpr std::size_t frame_alignment =
+    __STDCPP_DEFAULT_NEW_ALIGNMENT__;
+
+/**
+ * Returns the offset of the footer of a frame of the given size.
+ */
+constexpr std::size_t footer_offset(std::size_t size) noexcept
+{
+    return (size + alignof(frame_footer) - 1) &
+           ~(alignof(frame_footer) - 1);
+}
+
+/**
+ * Returns the allocation size of a frame of the given size.
+ */
+constexpr std::size_t allocation_size(std::size_t size) noexcept
+{
+    return footer_offset(size) + sizeof(frame_footer);
+}
+
+/**
+ * The promise operations that do not depend on the result type -
+ * frame allocation and the continuation.
+ */
+class promise_base
+{
+public:
+    /**
+     * Allocates a frame from the frame allocator of the innermost
+     * 'zpp::frame_allocator_scope' of the calling thread, or from the
+     * global heap if there is none.
+     */
+    static void * operator new(std::size_t size) noexcept
+    {
+        auto & current = current_frame_allocator();
+        auto frame =
+            current.allocate
+                ? current.allocate(current.allocator, allocation_size(size))
+                : ::operator new(allocation_size(size), std::nothrow);
+        if (!frame) ZPP_MAYBE_UNLIKELY {
+            return nullptr;
+        }
+        ::new (static_cast<unsigned char *>(frame) + footer_offset(size))
+            frame_footer{current.allocate ? current.deallocate
+                                          : global_deallocate,
+                         current.allocator};
+        return frame;
+    }
+
+    /**
+     * Releases a frame using the allocator it was allocated from.
+     */
+    static void operator delete(void * frame, std::size_t size) noexcept
+    {
+        auto footer = reinterpret_cast<frame_footer *>(
+            static_cast<unsigned char *>(frame) + footer_offset(size));
+        footer->deallocate(footer->allocator, frame, allocation_size(size));
+    }
+
+    /**
+     * Coroutines start when they are awaited or run.
+     */
+    std::suspend_always initial_suspend() const noexcept
+    {
+        return {};
+    }
+
+    /**
+     * Exceptions are not supported.
+     */
+    void unhandled_exception() const noexcept
+    {
+        std::terminate();
+    }
+
+    /**
+     * Fails the awaiting coroutine of the given address with the given
+     * error, and returns the coroutine to resume next.
+     */
+    using fail_function = std::coroutine_handle<> (*)(
+        void * awaiting, const error & other) noexcept;
+
+    /**
+     * Sets the awaiting coroutine, which is resumed when this one
+     * completes with a value, and is failed using the given function
+     * when this one completes with an error.
+     */
+    void set_awaiting(std::coroutine_handle<> awaiting,
+                      fail_function fail) noexcept
+    {
+        m_continuation = awaiting;
+        m_fail = fail;
+    }
+
+    /**
+     * Returns the coroutine to resume when this one completes with
+     * a value.
+     */
+    std::coroutine_handle<> complete() const noexcept
+    {
+        return m_continuation;
+    }
+
+    /**
+     * Returns the coroutine to resume when this one completes with the
+     * given error. The awaiting coroutine, if any, is completed with the
+     * error as well, without being resumed.
+     */
+    std::coroutine_handle<> complete(const error & other) const noexcept
+    {
+        if (m_fail) {
+            return m_fail(m_continuation.address(), other);
+        }
+        return m_continuation;
+    }
+
+private:
+    /**
+     * The coroutine to resume when this one completes.
+     */
+    std::coroutine_handle<> m_continuation = std::noop_coroutine();
+
+    /**
+     * Fails the awaiting coroutine, null if there is none.
+     */
+    fail_function m_fail{};
+};
+
+/**
+ * Awaits a maybe, resumes with the value if there is one, otherwise,
+ * completes the awaiting coroutine with the error.
+ */
+template <typename Maybe>
+class maybe_awaiter
+{
+public:
+    explicit maybe_awaiter(Maybe && maybe) noexcept(
+        std::is_nothrow_constructible_v<Maybe, Maybe &&>) :
+        m_maybe(std::forward<Maybe>(maybe))
+    {
+    }
+
+    bool await_ready() const noexcept
+    {
+        return bool(m_maybe);
+    }
+
+    template <typename Promise>
+    std::coroutine_handle<>
+    await_suspend(std::coroutine_handle<Promise> handle) noexcept
+    {
+        return handle.promise().fail(m_maybe.error());
+    }
+
+    decltype(auto) await_resume()
+    {
+        if constexpr (std::is_reference_v<Maybe>) {
+            return m_maybe.value();
+        } else {
+            return std::move(m_maybe).value();
+        }
+    }
+
+private:
+    /**
+     * The awaited maybe, a reference for lvalues.
+     */
+    Maybe m_maybe;
+};
+
+/**
+ * Holds the result of maybe tasks, set from the returned maybe.
+ */
+template <typename Type>
+class promise_return : public promise_base
+{
+public:
+    /**
+     * Sets the result of the coroutine.
+     */
+    void return_value(maybe<Type> result) noexcept(
+        std::is_nothrow_move_constructible_v<Type>)
+    {
+        m_result.emplace(std::move(result));
+    }
+
+protected:
+    /**
+     * The result of the coroutine.
+     */
+    std::optional<maybe<Type>> m_result;
+};
+
+/**
+ * Holds the result of maybe tasks of void, which succeed by
+ * 'co_return;' and fail by awaiting a maybe that holds an error.
+ */
+template <>
+class promise_return<void> : public promise_base
+{
+public:
+    /**
+     * Sets the result of the coroutine to success.
+     */
+    void return_void() noexcept
+    {
+        m_result.emplace();
+    }
+
+protected:
+    /**
+     * The result of the coroutine.
+     */
+    std::optional<maybe<void>> m_result;
+};
+
+/**
+ * The promise of maybe tasks.
+ */
+template <typename Type>
+class promise : public promise_return<Type>
+{
+public:
+    /**
+     * Receives the result of a task that is not awaited once it
+     * completes, with the given state.
+     */
+    using completion_function = void (*)(void * state,
+                                         maybe<Type> & result) noexcept;
+
+    /**
+     * Returns the task.
+     */
+    maybe_task<Type> get_return_object() noexcept
+    {
+        return maybe_task<Type>(
+            std::coroutine_handle<promise>::from_promise(*this));
+    }
+
+    /**
+     * Returns a completed task with an error, if the frame could not
+     * be allocated.
+     */
+    static maybe_task<Type> get_return_object_on_allocation_failure() noexcept
+    {
+        return maybe_task<Type>(coroutine_error::frame_allocation_failed);
+    }
+
+    /**
+     * Completes the coroutine with the given error, and returns the
+     * coroutine to resume next.
+     */
+    std::coroutine_handle<> fail(const error & other) noexcept
+    {
+        this->m_result.emplace(other);
+        return notify(this->complete(other));
+    }
+
+    /**
+     * Calls the given function with the given state and the result once
+     * the coroutine completes, for tasks that are not awaited.
+     */
+    void set_completion(completion_function completion,
+                        void * state) noexcept
+    {
+        m_completion = completion;
+        m_completion_state = state;
+    }
+
+    /**
+     * Calls the completion function, if any, and returns the given
+     * coroutine to resume next. The completion function may destroy the
+     * coroutine, which is not accessed afterwards.
+     */
+    std::coroutine_handle<> notify(std::coroutine_handle<> next) noexcept
+    {
+        if (m_completion) {
+            m_completion(m_completion_state, this->result());
+        }
+        return next;
+    }
+
+    /**
+     * Resumes the awaiting coroutine at the end, or completes it with
+     * the error of this coroutine.
+     */
+    auto final_suspend() const noexcept
+    {
+        struct awaiter
+        {
+            bool await_ready() const noexcept
+            {
+                return false;
+            }
+
+            std::coroutine_handle<> await_suspend(
+                std::coroutine_handle<promise> handle) const noexcept
+            {
+                auto & promise = handle.promise();
+                if (auto & result = promise.result(); !result) {
+                    return promise.notify(promise.complete(result.error()));
+                }
+                return promise.notify(promise.complete());
+            }
+
+            void await_resume() const noexcept
+            {
+            }
+        };
+        return awaiter{};
+    }
+
+    /**
+     * Awaits a maybe by its value, short circuiting the coroutine
+     * with the error if there is one.
+     */
+    template <typename Maybe,
+              typename = std::enable_if_t<
+                  is_maybe<std::remove_cvref_t<Maybe>>::value>>
+    auto await_transform(Maybe && maybe) noexcept(
+        std::is_nothrow_constructible_v<Maybe, Maybe &&>)
+    {
+        return maybe_awaiter<Maybe>(std::forward<Maybe>(maybe));
+    }
+
+    /**
+     * Other awaitables are awaited as is.
+     */
+    template <typename Awaitable,
+              typename = std::enable_if_t<
+                  !is_maybe<std::remove_cvref_t<Awaitable>>::value>,
+              typename = void>
+    Awaitable && await_transform(Awaitable && awaitable) noexcept
+    {
+        return std::forward<Awaitable>(awaitable);
+    }
+
+    /**
+     * Returns true if the result is set, else false.
+     */
+    bool has_result() const noexcept
+    {
+        return this->m_result.has_value();
+    }
+
+    /**
+     * Returns the result, which must be set.
+     */
+    maybe<Type> & result() noexcept
+    {
+        return *this->m_result;
+    }
+
+    /**
+     * Returns the result, which must be set.
+     */
+    const maybe<Type> & result() const noexcept
+    {
+        return *this->m_result;
+    }
+
+private:
+    /**
+     * Called once the coroutine completes, null if there is none.
+     */
+    completion_function m_completion{};
+
+    /**
+     * The state of the completion function.
+     */
+    void * m_completion_state{};
+};
+} // namespace coroutine_detail
+
+/**
+ * Allocates the frames of the maybe task coroutines that are called by
+ * the constructing thread during the lifetime of the scope from the
+ * given allocator, which must outlive the frames. Scopes may be nested.
+ * The allocator is any type with the 'allocate(size, alignment)' and
+ * 'deallocate(pointer, size, alignment)' member functions, such as
+ * 'zpp::frame_arena' or the standard memory resources, and should
+ * return null rather than throw when it is exhausted.
+ */
+class frame_allocator_scope
+{
+public:
+    template <typename Allocator>
+    explicit frame_allocator_scope(Allocator & allocator) noexcept :
+        m_previous(coroutine_detail::current_frame_allocator())
+    {
+        coroutine_detail::current_frame_allocator() = {
+            [](void * state, std::size_t size) noexcept -> void * {
+                return static_cast<Allocator *>(state)->allocate(
+                    size, coroutine_detail::frame_alignment);
+            },
+            [](void * state, void * frame, std::size_t size) noexcept {
+                static_cast<Allocator *>(state)->deallocate(
+                    frame, size, coroutine_detail::frame_alignment);
+            },
+            std::addressof(allocator)};
+    }
+
+    frame_allocator_scope(const frame_allocator_scope &) = delete;
+    frame_allocator_scope & operator=(const frame_allocator_scope &) = delete;
+
+    /**
+     * Restores the previous frame allocator.
+     */
+    ~frame_allocator_scope()
+    {
+        coroutine_detail::current_frame_allocator() = m_previous;
+    }
+
+private:
+    /**
+     * The previous frame allocator.
+     */
+    coroutine_detail::frame_allocator m_previous;
+};
+
+/**
+ * A lazily started coroutine that results in a maybe.
+ * Inside the coroutine, 'co_await' on a maybe evaluates to the value
+ * if there is one, otherwise, the coroutine completes with the error,
+ * and 'co_await' on another maybe task does the same with its result.
+ *
+ * Frames are allocated from the global heap, unless a
+ * 'zpp::frame_allocator_scope' is active on the calling thread, in which
+ * case they are allocated from its allocator, such as a
+ * 'zpp::frame_arena'. If the frame cannot be allocated, the task results
+ * in 'coroutine_error::frame_allocation_failed'.
+ * Example:
+ * ~~~
+ * zpp::maybe_task<int> sum(std::string_view first, std::string_view second)
+ * {
+ *     auto left = co_await parse(first);
+ *     auto right = co_await parse(second);
+ *     co_return left + right;
+ * }
+ *
+ * zpp::frame_arena<4096> arena;
+ * zpp::frame_allocator_scope scope(arena);
+ * auto result = sum("1", "2").run();
+ * ~~~
+ */
+template <typename Type>
+class maybe_task
+{
+public:
+    /**
+     * The promise type.
+     */
+    using promise_type = coroutine_detail::promise<Type>;
+
+    /**
+     * Move constructs the task.
+     */
+    maybe_task(maybe_task && other) noexcept :
+        m_handle(std::exchange(other.m_handle, {})),
+        m_error(std::exchange(other.m_error, coroutine_error::moved_from))
+    {
+    }
+
+    /**
+     * Move assigns the task.
+     */
+    maybe_task & operator=(maybe_task && other) noexcept
+    {
+        if (this != &other) {
+            destroy();
+            m_handle = std::exchange(other.m_handle, {});
+            m_error =
+                std::exchange(other.m_error, coroutine_error::moved_from);
+        }
+        return *this;
+    }
+
+    /**
+     * Destroys the coroutine.
+     */
+    ~maybe_task()
+    {
+        destroy();
+    }
+
+    /**
+     * Returns true if the result of the task is available, else false.
+     */
+    bool ready() const noexcept
+    {
+        return !m_handle || m_handle.promise().has_result();
+    }
+
+    /**
+     * Starts or continues the task on the calling thread, and returns
+     * its result. If the task suspends waiting for an asynchronous
+     * event, returns 'coroutine_error::suspended' instead, use 'start()'
+     * to receive the result of such tasks. A moved from task results in
+     * 'coroutine_error::moved_from'.
+     */
+    maybe<Type> run() &&
+    {
+        if (!m_handle) ZPP_MAYBE_UNLIKELY {
+            return m_error;
+        }
+        if (!m_handle.promise().has_result()) {
+            m_handle.resume();
+            if (!m_handle.promise().has_result()) ZPP_MAYBE_UNLIKELY {
+                return coroutine_error::suspended;
+            }
+        }
+        return std::move(m_handle.promise().result());
+    }
+
+    /**
+     * Starts or continues the task on the calling thread, and calls
+     * 'on_complete(result)' with a reference to its result once it is
+     * available - upon return, or later on the thread that resumes the
+     * task after an asynchronous event. The function may move from the
+     * result and may destroy the task, and otherwise both the task and
+     * the function must stay alive until it is called. Tasks that are
+     * awaited by other tasks must not be started.
+     *
+     * Example:
+     * ~~~
+     * auto on_complete = [](zpp::maybe<int> & result) { ... };
+     * auto task = receive(socket);
+     * task.start(on_complete);
+     * ~~~
+     */
+    template <typename Function>
+    void start(Function & on_complete) &
+    {
+        if (!m_handle) ZPP_MAYBE_UNLIKELY {
+            maybe<Type> failure = m_error;
+            std::invoke(on_complete, failure);
+            return;
+        }
+
+        auto & promise = m_handle.promise();
+        if (promise.has_result()) {
+            std::invoke(on_complete, promise.result());
+            return;
+        }
+        promise.set_completion(
+            [](void * state, maybe<Type> & result) noexcept {
+                std::invoke(*static_cast<Function *>(state), result);
+            },
+            std::addressof(on_complete));
+        m_handle.resume();
+    }
+
+    /**
+     * Awaits the task from another maybe task, evaluates to the value
+     * of the result, or completes the awaiting coroutine with its error.
+     */
+    coroutine_detail::task_awaiter<Type> operator co_await() && noexcept
+    {
+        return coroutine_detail::task_awaiter<Type>(*this);
+    }
+
+private:
+    template <typename>
+    friend class coroutine_detail::promise;
+
+    template <typename>
+    friend class coroutine_detail::task_awaiter;
+
+    /**
+     * Constructs a task of the given coroutine.
+     */
+    explicit maybe_task(
+        std::coroutine_handle<promise_type> handle) noexcept :
+        m_handle(handle)
+    {
+    }
+
+    /**
+     * Constructs a completed task with the given error.
+     */
+    explicit maybe_task(coroutine_error failure) noexcept : m_error(failure)
+    {
+    }
+
+    /**
+     * Destroys the coroutine.
+     */
+    void destroy() noexcept
+    {
+        if (m_handle) {
+            m_handle.destroy();
+        }
+    }
+
+    /**
+     * The coroutine, null if the frame could not be allocated or the
+     * task was moved from.
+     */
+    std::coroutine_handle<promise_type> m_handle;
+
+    /**
+     * The error if there is no coroutine, because the frame could not be
+     * allocated or the task was moved from.
+     */
+    error m_error = coroutine_error::success;
+};
+
+namespace coroutine_detail
+{
+/**
+ * Awaits a maybe task from another maybe task.
+ */
+template <typename Type>
+class task_awaiter
+{
+public:
+    explicit task_awaiter(maybe_task<Type> & task) noexcept : m_task(task)
+    {
+    }
+
+    /**
+     * Returns true if the task has already completed with a value,
+     * in which case it is not resumed again.
+     */
+    bool await_ready() const noexcept
+    {
+        return m_task.m_handle && m_task.m_handle.promise().has_result() &&
+               m_task.m_handle.promise().result();
+    }
+
+    template <typename Promise>
+    std::coroutine_handle<>
+    await_suspend(std::coroutine_handle<Promise> handle) noexcept
+    {
+        static_assert(std::is_base_of_v<promise_base, Promise>,
+                      "Maybe tasks may only be awaited by maybe tasks.");
+        if (!m_task.m_handle) ZPP_MAYBE_UNLIKELY {
+            return handle.promise().fail(m_task.m_error);
+        }
+        if (auto & awaited = m_task.m_handle.promise();
+            awaited.has_result()) {
+            // The task has already completed with an error.
+            return handle.promise().fail(awaited.result().error());
+        }
+        m_task.m_handle.promise().set_awaiting(
+            handle, [](void * awaiting, const error & other) noexcept {
+                return std::coroutine_handle<Promise>::from_address(awaiting)
+                    .promise()
+                    .fail(other);
+            });
+        return m_task.m_handle;
+    }
+
+    Type await_resume()
+    {
+        return std::move(m_task.m_handle.promise().result()).value();
+    }
+
+private:
+    /**
+     * The awaited task.
+     */
+    maybe_task<Type> & m_task;
+};
+} // namespace coroutine_detail
+} // namespace zpp
@@ -0,0 +1,572 @@
+#pragma once
+#include "maybe.h"
+
+#if __cplusplus < 202002L
+#error "zpp/maybe_execution.h requires C++20."
+#endif
+
+/**
+ * The namespace of the sender and receiver implementation to adapt to,
+ * which must provide the P2300 customization points and types such as
+ * 'connect', 'set_value' and 'completion_signatures_of_t'. Defaults to
+ * 'std::execution' where it is available, otherwise it must be defined
+ * after including the implementation, for example to 'stdexec'.
+ */
+#ifndef ZPP_MAYBE_EXECUTION_NAMESPACE
+#if defined(__has_include)
+#if __has_include(<execution>)
+#include <execution>
+#endif
+#endif
+#if defined(__cpp_lib_senders)
+#define ZPP_MAYBE_EXECUTION_NAMESPACE std::execution
+#else
+#error "zpp/maybe_execution.h requires ZPP_MAYBE_EXECUTION_NAMESPACE."
+#endif
+#endif
+
+#include <cstddef>
+#include <exception>
+#include <type_traits>
+#include <utility>
+
+namespace zpp
+{
+/**
+ * Implementation details of the sender adaptors.
+ */
+namespace execution_detail
+{
+namespace ex = ZPP_MAYBE_EXECUTION_NAMESPACE;
+
+/**
+ * Concatenates completion signatures, dropping duplicates.
+ */
+template <typename Result, typename... Lists>
+struct concat_unique
+{
+    using type = Result;
+};
+
+template <typename... Signatures, typename... Lists>
+struct concat_unique<ex::completion_signatures<Signatures...>,
+                     ex::completion_signatures<>,
+                     Lists...>
+    : concat_unique<ex::completion_signatures<Signatures...>, Lists...>
+{
+};
+
+template <typename... Signatures,
+          typename Signature,
+          typename... Rest,
+          typename... Lists>
+struct concat_unique<ex::completion_signatures<Signatures...>,
+                     ex::completion_signatures<Signature, Rest...>,
+                     Lists...>
+    : concat_unique<
+          std::conditional_t<
+              (std::is_same_v<Signature, Signatures> || ...),
+              ex::completion_signatures<Signatures...>,
+              ex::completion_signatures<Signatures..., Signature>>,
+          ex::completion_signatures<Rest...>,
+          Lists...>
+{
+};
+
+template <typename... Lists>
+using concat_unique_t =
+    typename concat_unique<ex::completion_signatures<>, Lists...>::type;
+
+/**
+ * The number of completion signatures.
+ */
+template <typename Signatures>
+struct signature_count;
+
+template <typename... Signatures>
+struct signature_count<ex::completion_signatures<Signatures...>>
+    : std::integral_constant<std::size_t, sizeof...(Signatures)>
+{
+};
+
+/**
+ * The number of values of a completion signature, zero for completions
+ * other than values.
+ */
+template <typename Signature>
+struct value_count : std::integral_constant<std::size_t, 0>
+{
+};
+
+template <typename... Values>
+struct value_count<ex::set_value_t(Values...)>
+    : std::integral_constant<std::size_t, sizeof...(Values)>
+{
+};
+
+/**
+ * Whether the given type is a maybe.
+ */
+template <typename Type>
+struct is_maybe : std::false_type
+{
+};
+
+template <typename Type, typename Payload>
+struct is_maybe<maybe<Type, Payload>> : std::true_type
+{
+};
+
+/**
+ * Whether the given type is an error, with or without a payload.
+ */
+template <typename Type>
+inline constexpr bool is_error_v =
+    std::is_base_of_v<error_detail::error, std::remove_cvref_t<Type>>;
+
+/**
+ * The completions of 'unwrap_maybe' for a value completion of the
+ * child sender, which sends a maybe.
+ */
+template <typename Maybe>
+struct unwrap_value
+{
+    using type = ex::completion_signatures<
+        ex::set_value_t(typename Maybe::type),
+        ex::set_error_t(typename Maybe::error_type)>;
+};
+
+template <typename Payload>
+struct unwrap_value<maybe<void, Payload>>
+{
+    using type = ex::completion_signatures<
+        ex::set_value_t(),
+        ex::set_error_t(typename maybe<void, Payload>::error_type)>;
+};
+
+/**
+ * The completions of 'unwrap_maybe' for a completion of the child
+ * sender, values that are maybe are split into a value and an error,
+ * and other completions are kept.
+ */
+template <typename Signature>
+struct unwrap_signature
+{
+    using type = ex::completion_signatures<Signature>;
+};
+
+template <typename Value>
+struct unwrap_signature<ex::set_value_t(Value)>
+{
+    using type = typename std::conditional_t<
+        is_maybe<std::remove_cvref_t<Value>>::value,
+        unwrap_value<std::remove_cvref_t<Value>>,
+        std::type_identity<ex::completion_signatures<ex::set_value_t(
+            Value)>>>::type;
+};
+
+template <typename Signatures>
+struct unwrap_signatures;
+
+template <typename... Signatures>
+struct unwrap_signatures<ex::completion_signatures<Signatures...>>
+{
+    using type =
+        concat_unique_t<typename unwrap_signature<Signatures>::type...>;
+};
+
+/**
+ * The receiver that 'unwrap_maybe' connects to the child sender.
+ */
+template <typename Receiver>
+struct unwrap_receiver
+{
+    using receiver_concept = ex::receiver_t;
+
+    template <typename... Values>
+    void set_value(Values &&... values) && noexcept
+    {
+        if constexpr (sizeof...(Values) == 1 &&
+                      (is_maybe<std::remove_cvref_t<Values>>::value &&
+                       ...)) {
+            (unwrap(std::forward<Values>(values)), ...);
+        } else {
+            ex::set_value(std::move(m_receiver),
+                          std::forward<Values>(values)...);
+        }
+    }
+
+    template <typename Error>
+    void set_error(Error && failure) && noexcept
+    {
+        ex::set_error(std::move(m_receiver), std::forward<Error>(failure));
+    }
+
+    void set_stopped() && noexcept
+    {
+        ex::set_stopped(std::move(m_receiver));
+    }
+
+    decltype(auto) get_env() const noexcept
+    {
+        return ex::get_env(m_receiver);
+    }
+
+    /**
+     * Completes the receiver with the value or error of the maybe.
+     */
+    template <typename Maybe>
+    void unwrap(Maybe && maybe) noexcept
+    {
+        if (!maybe) ZPP_MAYBE_UNLIKELY {
+            ex::set_error(std::move(m_receiver), maybe.error());
+        } else if constexpr (std::is_void_v<
+                                 typename std::remove_cvref_t<Maybe>::type>) {
+            ex::set_value(std::move(m_receiver));
+        } else {
+            ex::set_value(std::move(m_receiver),
+                          std::forward<Maybe>(maybe).value());
+        }
+    }
+
+    /**
+     * The receiver to complete.
+     */
+    Receiver m_receiver;
+};
+
+/**
+ * The sender of 'unwrap_maybe'.
+ */
+template <typename Child>
+struct unwrap_sender
+{
+    using sender_concept = ex::sender_t;
+
+    template <typename Env>
+    auto get_completion_signatures(Env &&) const noexcept ->
+        typename unwrap_signatures<
+            ex::completion_signatures_of_t<const Child &, Env>>::type
+    {
+        return {};
+    }
+
+    template <typename Receiver>
+    auto connect(Receiver receiver) && noexcept(noexcept(
+        ex::connect(std::move(m_child),
+                    unwrap_receiver<Receiver>{std::move(receiver)})))
+    {
+        return ex::connect(std::move(m_child),
+                           unwrap_receiver<Receiver>{std::move(receiver)});
+    }
+
+    template <typename Receiver>
+    auto connect(Receiver receiver) const & noexcept(noexcept(ex::connect(
+        m_child, unwrap_receiver<Receiver>{std::move(receiver)})))
+    {
+        return ex::connect(m_child,
+                           unwrap_receiver<Receiver>{std::move(receiver)});
+    }
+
+    decltype(auto) get_env() const noexcept
+    {
+        return ex::get_env(m_child);
+    }
+
+    /**
+     * The child sender.
+     */
+    Child m_child;
+};
+
+/**
+ * Whether a maybe is constructed from the given arguments and moved to
+ * the receiver without throwing.
+ */
+template <typename Maybe, typename... Arguments>
+inline constexpr bool nothrow_send_v =
+    std::is_nothrow_constructible_v<Maybe, Arguments...> &&
+    std::is_nothrow_move_constructible_v<Maybe>;
+
+/**
+ * The maybe that 'as_maybe' sends for a value completion of the child
+ * sender, and whether sending it cannot throw.
+ */
+template <typename Signature>
+struct maybe_of_value
+{
+    using type = ex::completion_signatures<>;
+    static constexpr bool nothrow = true;
+};
+
+template <typename Value>
+struct maybe_of_value<ex::set_value_t(Value)>
+{
+    using maybe_type = zpp::maybe<std::remove_cvref_t<Value>>;
+    using type = ex::completion_signatures<ex::set_value_t(maybe_type)>;
+    static constexpr bool nothrow =
+        nothrow_send_v<maybe_type, std::in_place_t, Value>;
+};
+
+template <>
+struct maybe_of_value<ex::set_value_t()>
+{
+    using type = ex::completion_signatures<ex::set_value_t(zpp::maybe<void>)>;
+    static constexpr bool nothrow = true;
+};
+
+/**
+ * The completions of 'as_maybe' for a completion of the child sender
+ * other than a value - errors that are 'zpp::error' become values.
+ */
+template <typename Signature>
+struct as_maybe_signature
+{
+    using type = ex::completion_signatures<Signature>;
+};
+
+template <typename... Values>
+struct as_maybe_signature<ex::set_value_t(Values...)>
+{
+    using type = ex::completion_signatures<>;
+};
+
+template <typename Error>
+struct as_maybe_signature<ex::set_error_t(Error)>
+{
+    using type = std::conditional_t<
+        is_error_v<Error>,
+        ex::completion_signatures<>,
+        ex::completion_signatures<ex::set_error_t(Error)>>;
+};
+
+template <typename Signatures>
+struct as_maybe_signatures;
+
+template <typename... Signatures>
+struct as_maybe_signatures<ex::completion_signatures<Signatures...>>
+{
+    using values =
+        concat_unique_t<typename maybe_of_value<Signatures>::type...>;
+
+    // Each check assumes the previous ones hold, so that exactly one of
+    // them reports the problem.
+    static constexpr bool single_values =
+        ((value_count<Signatures>::value <= 1) && ...);
+    static_assert(single_values,
+                  "The sender must complete with at most one value at a "
+                  "time, a maybe cannot hold several.");
+    static_assert(!single_values || signature_count<values>::value != 0,
+                  "The sender must complete with a value.");
+    static_assert(!single_values || signature_count<values>::value <= 1,
+                  "The sender must complete with a single kind of value.");
+
+    // A maybe that throws while it is constructed or moved is sent as an
+    // exception instead.
+#if defined(__cpp_exceptions)
+    using exceptions = std::conditional_t<
+        (maybe_of_value<Signatures>::nothrow && ...),
+        ex::completion_signatures<>,
+        ex::completion_signatures<ex::set_error_t(std::exception_ptr)>>;
+#else
+    using exceptions = ex::completion_signatures<>;
+#endif
+
+    using type =
+        concat_unique_t<values,
+                        typename as_maybe_signature<Signatures>::type...,
+                        exceptions>;
+};
+
+/**
+ * Returns the maybe type of a set value signature.
+ */
+template <typename Signature>
+struct maybe_of_signature;
+
+template <typename Maybe>
+struct maybe_of_signature<ex::set_value_t(Maybe)>
+{
+    using type = Maybe;
+};
+
+template <typename Maybe>
+struct maybe_of_completions;
+
+template <typename Signature, typename... Signatures>
+struct maybe_of_completions<
+    ex::completion_signatures<Signature, Signatures...>>
+    : maybe_of_signature<Signature>
+{
+};
+
+/**
+ * The receiver that 'as_maybe' connects to the child sender.
+ */
+template <typename Maybe, typename Receiver>
+struct as_maybe_receiver
+{
+    using receiver_concept = ex::receiver_t;
+
+    template <typename... Values>
+    void set_value(Values &&... values) && noexcept
+    {
+        send(std::in_place, std::forward<Values>(values)...);
+    }
+
+    template <typename Error>
+    void set_error(Error && failure) && noexcept
+    {
+        if constexpr (is_error_v<Error>) {
+            send(failure);
+        } else {
+            ex::set_error(std::move(m_receiver),
+                          std::forward<Error>(failure));
+        }
+    }
+
+    void set_stopped() && noexcept
+    {
+        ex::set_stopped(std::move(m_receiver));
+    }
+
+    decltype(auto) get_env() const noexcept
+    {
+        return ex::get_env(m_receiver);
+    }
+
+    /**
+     * Completes the receiver with a maybe constructed from the given
+     * arguments, or with the exception that constructing or moving it
+     * throws.
+     */
+    template <typename... Arguments>
+    void send(Arguments &&... arguments) noexcept
+    {
+#if defined(__cpp_exceptions)
+        if constexpr (!nothrow_send_v<Maybe, Arguments &&...>) {
+            try {
+                ex::set_value(std::move(m_receiver),
+                              Maybe(std::forward<Arguments>(arguments)...));
+            } catch (...) {
+                ex::set_error(std::move(m_receiver),
+                              std::current_exception());
+            }
+            return;
+        }
+#endif
+        ex::set_value(std::move(m_receiver),
+                      Maybe(std::forward<Arguments>(arguments)...));
+    }
+
+    /**
+     * The receiver to complete.
+     */
+    Receiver m_receiver;
+};
+
+/**
+ * The sender of 'as_maybe'.
+ */
+template <typename Child>
+struct as_maybe_sender
+{
+    using sender_concept = ex::sender_t;
+
+    template <typename Env>
+    using signatures = typename as_maybe_signatures<
+        ex::completion_signatures_of_t<const Child &, Env>>::type;
+
+    template <typename Env>
+    using maybe_type = typename maybe_of_completions<
+        typename as_maybe_signatures<
+            ex::completion_signatures_of_t<const Child &, Env>>::values>::
+        type;
+
+    template <typename Env>
+    auto get_completion_signatures(Env &&) const noexcept -> signatures<Env>
+    {
+        return {};
+    }
+
+    template <typename Receiver>
+    auto connect(Receiver receiver) &&
+    {
+        using result_type = maybe_type<ex::env_of_t<Receiver>>;
+        return ex::connect(
+            std::move(m_child),
+            as_maybe_receiver<result_type, Receiver>{std::move(receiver)});
+    }
+
+    template <typename Receiver>
+    auto connect(Receiver receiver) const &
+    {
+        using result_type = maybe_type<ex::env_of_t<Receiver>>;
+        return ex::connect(
+            m_child,
+            as_maybe_receiver<result_type, Receiver>{std::move(receiver)});
+    }
+
+    decltype(auto) get_env() const noexcept
+    {
+        return ex::get_env(m_child);
+    }
+
+    /**
+     * The child sender.
+     */
+    Child m_child;
+};
+
+/**
+ * Makes the adaptor usable on the right hand side of a pipe.
+ */
+template <template <typename> typename Sender>
+struct adaptor
+{
+    template <typename Child>
+    constexpr auto operator()(Child && child) const
+    {
+        return Sender<std::remove_cvref_t<Child>>{std::forward<Child>(child)};
+    }
+
+    template <typename Child>
+    friend constexpr auto operator|(Child && child, adaptor self)
+    {
+        return self(std::forward<Child>(child));
+    }
+};
+} // namespace execution_detail
+
+/**
+ * Adapts a sender of 'zpp::maybe', completing with its value through
+ * 'set_value', or with its error through 'set_error'. The operation
+ * state of the child is stored inline, nothing is allocated.
+ *
+ * Example:
+ * ~~~
+ * auto sender = ex::just(zpp::maybe<int>(1337)) | zpp::unwrap_maybe |
+ *               ex::then([](int value) { return value + 1; });
+ * ~~~
+ */
+inline constexpr execution_detail::adaptor<execution_detail::unwrap_sender>
+    unwrap_maybe{};
+
+/**
+ * Adapts a sender into a sender of 'zpp::maybe', completing with a maybe
+ * holding its value, or the 'zpp::error' it completes with through
+ * 'set_error'. Other errors and stop requests are forwarded as is, and
+ * an exception thrown while constructing the maybe is sent through
+ * 'set_error' as a 'std::exception_ptr'. The child must complete with
+ * a single kind of value, of at most one argument. The operation state
+ * of the child is stored inline, nothing is allocated.
+ *
+ * Example:
+ * ~~~
+ * auto sender = zpp::as_maybe(read_async(socket, buffer)) |
+ *               ex::then([](zpp::maybe<std::size_t> size) { ... });
+ * ~~~
+ */
+inline constexpr execution_detail::adaptor<execution_detail::as_maybe_sender>
+    as_maybe{};
+} // namespace zpp
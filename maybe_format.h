@@ -0,0 +1,166 @@
+#pragma once
+#include "maybe.h"
+#include <algorithm>
+#include <cstddef>
+#include <string_view>
+#include <type_traits>
+
+#if defined(__has_include)
+#if __has_include(<format>)
+#include <format>
+#endif
+#endif
+
+namespace zpp
+{
+/**
+ * Implementation details of error formatting.
+ */
+namespace format_detail
+{
+/**
+ * The maximum number of characters of a formatted error code.
+ */
+inline constexpr std::size_t max_code_size = 11;
+
+/**
+ * Writes the decimal representation of the code into the end of the
+ * given buffer of 'max_code_size' characters, and returns the first
+ * written character.
+ */
+constexpr char * write_code(int code, char * end) noexcept
+{
+    auto value = code < 0 ? 0u - unsigned(code) : unsigned(code);
+    do {
+        *--end = char('0' + value % 10);
+        value /= 10;
+    } while (value);
+    if (code < 0) {
+        *--end = '-';
+    }
+    return end;
+}
+
+/**
+ * Calls the given function with each part of the formatted error, in
+ * order - the category name, the code and the message.
+ */
+template <typename Function>
+void for_each_part(const error & other, Function && function)
+{
+    char code[max_code_size];
+    auto & category = other.category();
+    function(category.name());
+    function(std::string_view(":"));
+    auto first = write_code(other.code(), code + sizeof(code));
+    function(
+        std::string_view(first, std::size_t(code + sizeof(code) - first)));
+    function(std::string_view(": "));
+    function(category.message(other.code()));
+}
+} // namespace format_detail
+
+/**
+ * Writes the error formatted as "category:code: message" into the given
+ * buffer, at most 'size' characters and no null terminator, and
+ * returns the size of the whole formatted error, which was truncated
+ * if it is larger than 'size'. Nothing is allocated.
+ *
+ * Example:
+ * ~~~
+ * char buffer[128];
+ * auto size = zpp::format_to_n(buffer, sizeof(buffer), error);
+ * log(std::string_view(buffer, std::min(size, sizeof(buffer))));
+ * ~~~
+ */
+inline std::size_t
+format_to_n(char * buffer, std::size_t size, const error & other) noexcept
+{
+    std::size_t total = 0;
+    format_detail::for_each_part(other, [&](std::string_view part) {
+        if (total < size) {
+            part.copy(buffer + total, size - total);
+        }
+        total += part.size();
+    });
+    return total;
+}
+} // namespace zpp
+
+#if defined(__cpp_lib_format)
+/**
+ * Formats errors as "category:code: message".
+ */
+template <>
+struct std::formatter<zpp::error, char>
+{
+    constexpr auto parse(std::format_parse_context & context)
+    {
+        auto position = context.begin();
+        if (position != context.end() && *position != '}') {
+            throw std::format_error("Errors take no format specification.");
+        }
+        return position;
+    }
+
+    template <typename FormatContext>
+    auto format(const zpp::error & other, FormatContext & context) const
+    {
+        auto out = context.out();
+        zpp::format_detail::for_each_part(other, [&](std::string_view part) {
+            out = std::copy(part.begin(), part.end(), out);
+        });
+        return out;
+    }
+};
+
+/**
+ * Formats errors with a payload as errors without one.
+ */
+template <typename Payload>
+struct std::formatter<zpp::error_detail::basic_error<Payload>, char>
+    : std::formatter<zpp::error, char>
+{
+};
+
+/**
+ * Formats maybe objects as their value using the format specification
+ * of the value, or as their error.
+ */
+template <typename Type, typename Payload>
+struct std::formatter<zpp::maybe<Type, Payload>, char>
+    : std::formatter<std::remove_cvref_t<Type>, char>
+{
+    template <typename FormatContext>
+    auto format(const zpp::maybe<Type, Payload> & maybe,
+                FormatContext & context) const
+    {
+        if (!maybe) {
+            return std::formatter<zpp::error, char>{}.format(maybe.error(),
+                                                             context);
+        }
+        return std::formatter<std::remove_cvref_t<Type>, char>::format(
+            maybe.value(), context);
+    }
+};
+
+/**
+ * Formats maybe of void as "success", or as its error.
+ */
+template <typename Payload>
+struct std::formatter<zpp::maybe<void, Payload>, char>
+    : std::formatter<zpp::error, char>
+{
+    template <typename FormatContext>
+    auto format(const zpp::maybe<void, Payload> & maybe,
+                FormatContext & context) const
+    {
+        if (!maybe) {
+            return std::formatter<zpp::error, char>::format(maybe.error(),
+                                                            context);
+        }
+        std::string_view success = "success";
+        return std::copy(success.begin(), success.end(), context.out());
+    }
+};
+#endif
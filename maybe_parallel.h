@@ -0,0 +1,438 @@
+#pragma once
+#include "maybe.h"
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <iterator>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace zpp
+{
+/**
+ * Runs the workers of parallel algorithms, for example on the threads of
+ * an existing pool, instead of starting a thread for each of them.
+ */
+class parallel_executor
+{
+public:
+    /**
+     * Runs 'task(context)' once on another thread, now or later. The
+     * calling thread waits for every task it submitted, so the tasks must
+     * be able to run while it waits. Throws, and does not run the task,
+     * if it cannot be submitted.
+     */
+    virtual void execute(void (*task)(void *) noexcept, void * context) = 0;
+
+protected:
+    ~parallel_executor() = default;
+};
+
+/**
+ * Controls how 'parallel_transform_collect' distributes the work.
+ */
+struct parallel_policy
+{
+    /**
+     * The number of threads to use including the calling thread, zero
+     * to use the hardware concurrency.
+     */
+    unsigned concurrency = 0;
+
+    /**
+     * The number of elements in each chunk of work, zero to choose one
+     * from the size of the range and the concurrency.
+     */
+    std::size_t chunk_size = 0;
+
+    /**
+     * Whether to report the error of the lowest failing index, rather
+     * than the first error to occur.
+     */
+    bool deterministic = false;
+
+    /**
+     * The executor that runs the workers other than the calling thread,
+     * null to start a thread for each of them.
+     */
+    parallel_executor * executor = nullptr;
+};
+
+/**
+ * Reports the first error to occur, and stops all workers as soon as
+ * it is published.
+ */
+inline constexpr parallel_policy parallel{};
+
+/**
+ * Reports the error of the lowest failing index, workers stop once
+ * every element below it has been transformed.
+ */
+inline constexpr parallel_policy parallel_deterministic{0, 0, true};
+
+/**
+ * Implementation details of parallel algorithms.
+ */
+namespace parallel_detail
+{
+/**
+ * Marks that no element has failed.
+ */
+inline constexpr std::size_t no_failure = std::size_t(-1);
+
+/**
+ * The number of chunks per thread when choosing the chunk size, so
+ * that threads which finish early pick up the remaining chunks.
+ */
+inline constexpr std::size_t chunks_per_thread = 8;
+
+/**
+ * The error recorded by a single worker, on its own cache line.
+ */
+template <typename Error>
+struct alignas(64) worker_error
+{
+    std::size_t index = no_failure;
+    std::optional<Error> error;
+#if defined(__cpp_exceptions)
+    std::exception_ptr exception;
+#endif
+};
+
+/**
+ * Counts the workers submitted to an executor that did not finish yet.
+ */
+struct pending_workers
+{
+    std::mutex mutex;
+    std::condition_variable finished;
+    std::size_t count = 0;
+};
+
+/**
+ * A worker submitted to an executor, which runs the guarded work and
+ * then signals the calling thread.
+ */
+template <typename Guarded, typename Error>
+struct submitted_worker
+{
+    static void run(void * context) noexcept
+    {
+        auto & self = *static_cast<submitted_worker *>(context);
+        (*self.guarded)(*self.worker);
+
+        // Notify while locked, the waiter destroys the pending count as
+        // soon as it observes zero.
+        std::lock_guard lock(self.pending->mutex);
+        if (!--self.pending->count) {
+            self.pending->finished.notify_one();
+        }
+    }
+
+    Guarded * guarded;
+    worker_error<Error> * worker;
+    pending_workers * pending;
+};
+
+/**
+ * Rejects function results whose values cannot be collected.
+ */
+template <typename Result, bool References>
+constexpr void check_collectable() noexcept
+{
+    static_assert(!std::is_void_v<typename Result::type>,
+                  "zpp::maybe<void> has no values to collect, transform "
+                  "into a value type instead.");
+    static_assert(References || !std::is_reference_v<typename Result::type>,
+                  "References cannot be collected into a vector, transform "
+                  "into a value type or use the output iterator overload.");
+}
+
+/**
+ * Transforms the range into the output using the given policy, and
+ * returns the lowest index of the recorded errors, 'no_failure' if
+ * every element succeeded. An exception thrown by a worker, or while
+ * starting the threads, stops the others and is rethrown once all of
+ * them are joined.
+ */
+template <typename Error,
+          typename Input,
+          typename Output,
+          typename Function>
+std::size_t run(const parallel_policy & policy,
+                Input input,
+                std::size_t size,
+                Output output,
+                Function & function,
+                std::optional<Error> & result)
+{
+    if (!size) {
+        return no_failure;
+    }
+
+    std::size_t concurrency = policy.concurrency;
+    if (!concurrency) {
+        concurrency = std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    std::size_t chunk_size = policy.chunk_size;
+    if (!chunk_size) {
+        chunk_size =
+            std::max<std::size_t>(1, size / (concurrency * chunks_per_thread));
+    }
+
+    auto chunks = size / chunk_size + !!(size % chunk_size);
+    concurrency = std::min(concurrency, chunks);
+
+    std::atomic<std::size_t> cursor{};
+    std::atomic<std::size_t> failed{no_failure};
+    bool deterministic = policy.deterministic;
+
+    auto stopped = [&](std::size_t index) {
+        auto failure = failed.load(std::memory_order_relaxed);
+        return deterministic ? failure < index : failure != no_failure;
+    };
+
+    auto work = [&](worker_error<Error> & worker) {
+        while (true) {
+            auto first =
+                cursor.fetch_add(1, std::memory_order_relaxed) * chunk_size;
+            if (first >= size || stopped(first)) {
+                return;
+            }
+
+            auto last = std::min(size, first + chunk_size);
+            for (auto index = first; index != last; ++index) {
+                if (stopped(index)) ZPP_MAYBE_UNLIKELY {
+                    return;
+                }
+
+                auto value = std::invoke(function, input[index]);
+                if (value) ZPP_MAYBE_LIKELY {
+                    output[index] = std::move(value).value();
+                    continue;
+                }
+
+                // Publish the failing index, the error itself stays with
+                // the worker until all of them are joined.
+                auto failure = failed.load(std::memory_order_relaxed);
+                do {
+                    if (deterministic ? failure < index
+                                      : failure != no_failure) {
+                        return;
+                    }
+                } while (!failed.compare_exchange_weak(
+                    failure, index, std::memory_order_relaxed));
+
+                worker.index = index;
+                worker.error.emplace(value.error());
+                return;
+            }
+        }
+    };
+
+    // A single thread runs inline, its exceptions propagate directly.
+    if (concurrency == 1) {
+        worker_error<Error> worker;
+        work(worker);
+        if (worker.error) ZPP_MAYBE_UNLIKELY {
+            result.emplace(std::move(*worker.error));
+        }
+        return worker.index;
+    }
+
+    // An exception marks the first index as failed, which stops every
+    // worker in both modes.
+    auto guarded = [&](worker_error<Error> & worker) noexcept {
+#if defined(__cpp_exceptions)
+        try {
+            work(worker);
+        } catch (...) {
+            worker.exception = std::current_exception();
+            failed.store(0, std::memory_order_relaxed);
+        }
+#else
+        work(worker);
+#endif
+    };
+
+    std::vector<worker_error<Error>> errors(concurrency);
+    using submitted_type = submitted_worker<decltype(guarded), Error>;
+    std::vector<std::thread> threads;
+    std::vector<submitted_type> submitted;
+    pending_workers pending;
+    std::size_t unsubmitted = 0;
+#if defined(__cpp_exceptions)
+    try {
+#endif
+        if (auto executor = policy.executor) {
+            // Reserved up front, as the executor holds their addresses.
+            submitted.reserve(concurrency - 1);
+            unsubmitted = pending.count = concurrency - 1;
+            for (std::size_t i = 1; i < concurrency; ++i) {
+                submitted.push_back({&guarded, &errors[i], &pending});
+                executor->execute(&submitted_type::run, &submitted.back());
+                --unsubmitted;
+            }
+        } else {
+            threads.reserve(concurrency - 1);
+            for (std::size_t i = 1; i < concurrency; ++i) {
+                threads.emplace_back(guarded, std::ref(errors[i]));
+            }
+        }
+        guarded(errors[0]);
+#if defined(__cpp_exceptions)
+    } catch (...) {
+        // Only the calling thread uses the first worker.
+        errors[0].exception = std::current_exception();
+        failed.store(0, std::memory_order_relaxed);
+    }
+#endif
+    for (auto & thread : threads) {
+        thread.join();
+    }
+    {
+        std::unique_lock lock(pending.mutex);
+        pending.count -= unsubmitted;
+        pending.finished.wait(lock, [&] { return !pending.count; });
+    }
+
+#if defined(__cpp_exceptions)
+    for (auto & worker : errors) {
+        if (worker.exception) ZPP_MAYBE_UNLIKELY {
+            std::rethrow_exception(worker.exception);
+        }
+    }
+#endif
+
+    auto failure = failed.load(std::memory_order_relaxed);
+    if (failure != no_failure) ZPP_MAYBE_UNLIKELY {
+        for (auto & worker : errors) {
+            if (worker.index == failure) {
+                result.emplace(std::move(*worker.error));
+                break;
+            }
+        }
+    }
+    return failure;
+}
+} // namespace parallel_detail
+
+/**
+ * Transforms every element of a random access range using the given
+ * function returning 'zpp::maybe', across threads, and stores the
+ * values into the output random access iterator at the same indices.
+ * Returns the output iterator past the last element, or the error of a
+ * failed element, in which case the contents of the output are
+ * unspecified. Once an element fails the remaining work is abandoned,
+ * see 'parallel_policy'. If the function throws, the remaining work is
+ * abandoned and the exception is rethrown once every thread is joined.
+ *
+ * The function is called concurrently and must be safe to call so, and
+ * the output must not be a proxy iterator such as that of
+ * 'std::vector<bool>', whose elements cannot be assigned concurrently.
+ * Functions returning 'zpp::maybe<Type &>' assign the referenced values.
+ *
+ * Example:
+ * ~~~
+ * std::vector<int> values(inputs.size());
+ * auto end = zpp::parallel_transform_collect(
+ *     zpp::parallel, inputs, values.begin(), decode);
+ * ~~~
+ */
+template <typename Range, typename Output, typename Function>
+auto parallel_transform_collect(const parallel_policy & policy,
+                                Range && range,
+                                Output output,
+                                Function && function)
+{
+    using input_iterator = decltype(std::begin(range));
+    using result_type = std::remove_cv_t<std::remove_reference_t<
+        std::invoke_result_t<Function &,
+                             decltype(*std::declval<input_iterator>())>>>;
+    using error_type = typename result_type::error_type;
+
+    parallel_detail::check_collectable<result_type, true>();
+    static_assert(
+        std::is_base_of_v<
+            std::random_access_iterator_tag,
+            typename std::iterator_traits<input_iterator>::iterator_category>,
+        "The range must be random access.");
+    static_assert(
+        std::is_reference_v<typename std::iterator_traits<Output>::reference>,
+        "The output elements must be assignable concurrently, which proxy "
+        "iterators such as that of std::vector<bool> are not.");
+
+    std::size_t size = std::size(range);
+    std::optional<error_type> failure;
+    parallel_detail::run<error_type>(
+        policy, std::begin(range), size, output, function, failure);
+    if (failure) ZPP_MAYBE_UNLIKELY {
+        return maybe<Output, typename result_type::payload_type>(*failure);
+    }
+    return maybe<Output, typename result_type::payload_type>(
+        output + size);
+}
+
+/**
+ * Transforms every element of a random access range using the given
+ * function returning 'zpp::maybe', across threads, and collects the
+ * values in order into a vector, or returns the error of a failed
+ * element. Once an element fails the remaining work is abandoned, see
+ * 'parallel_policy'. If the function throws, the remaining work is
+ * abandoned and the exception is rethrown once every thread is joined.
+ *
+ * The function is called concurrently and must be safe to call so.
+ *
+ * Example:
+ * ~~~
+ * auto values = zpp::parallel_transform_collect(
+ *     zpp::parallel_deterministic, inputs, decode);
+ * if (!values) {
+ *     // The error of the lowest failing input.
+ * }
+ * ~~~
+ */
+template <typename Range, typename Function>
+auto parallel_transform_collect(const parallel_policy & policy,
+                                Range && range,
+                                Function && function)
+{
+    using result_type = std::remove_cv_t<std::remove_reference_t<
+        std::invoke_result_t<Function &, decltype(*std::begin(range))>>>;
+    parallel_detail::check_collectable<result_type, false>();
+
+    using value_type = typename result_type::type;
+    using collected =
+        maybe<std::vector<value_type>, typename result_type::payload_type>;
+
+    static_assert(std::is_default_constructible_v<value_type>,
+                  "The values are assigned into a sized vector, use the "
+                  "output iterator overload otherwise.");
+
+    // The elements of 'std::vector<bool>' share words and cannot be
+    // assigned concurrently, so booleans are collected as bytes.
+    using element_type = std::conditional_t<std::is_same_v<value_type, bool>,
+                                            unsigned char,
+                                            value_type>;
+
+    std::vector<element_type> values(std::size(range));
+    auto result = parallel_transform_collect(
+        policy, range, values.begin(), function);
+    if (!result) ZPP_MAYBE_UNLIKELY {
+        return collected(result.error());
+    }
+    if constexpr (std::is_same_v<value_type, bool>) {
+        return collected(std::vector<bool>(values.begin(), values.end()));
+    } else {
+        return collected(std::move(values));
+    }
+}
+} // namespace zpp
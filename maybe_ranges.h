@@ -0,0 +1,240 @@
+#pragma once
+#include "maybe.h"
+
+#if defined(__has_include)
+#if __has_include(<version>)
+#include <version>
+#endif
+#endif
+
+#if !defined(__cpp_lib_ranges) || !__has_include(<ranges>)
+#error "zpp/maybe_ranges.h requires C++20 ranges."
+#endif
+
+#include <concepts>
+#include <ranges>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace zpp
+{
+/**
+ * Implementation details of the range adaptors.
+ */
+namespace ranges_detail
+{
+/**
+ * Whether elements of the given range may be moved from, which is
+ * the case for rvalue ranges that own their elements.
+ */
+template <typename Range>
+inline constexpr bool movable_elements =
+    !std::is_lvalue_reference_v<Range> &&
+    !std::ranges::view<std::remove_cvref_t<Range>>;
+
+/**
+ * Returns whether the maybe holds a value.
+ */
+struct has_value
+{
+    template <typename Maybe>
+    constexpr bool operator()(const Maybe & maybe) const noexcept
+    {
+        return static_cast<bool>(maybe);
+    }
+};
+
+/**
+ * Returns whether the maybe holds an error.
+ */
+struct has_error
+{
+    template <typename Maybe>
+    constexpr bool operator()(const Maybe & maybe) const noexcept
+    {
+        return !maybe;
+    }
+};
+
+/**
+ * Returns a reference to the value of the maybe, an rvalue reference
+ * if 'Move' is set.
+ */
+template <bool Move>
+struct value_of
+{
+    template <typename Maybe>
+    constexpr decltype(auto) operator()(Maybe && maybe) const noexcept
+    {
+        if constexpr (Move) {
+            return std::move(maybe).value();
+        } else {
+            return std::forward<Maybe>(maybe).value();
+        }
+    }
+};
+
+/**
+ * Returns the error of the maybe.
+ */
+struct error_of
+{
+    template <typename Maybe>
+    constexpr auto operator()(const Maybe & maybe) const noexcept
+    {
+        return maybe.error();
+    }
+};
+
+/**
+ * Makes the adaptor usable on the right hand side of a pipe, for the
+ * ranges that the adaptor itself accepts.
+ */
+template <typename Adaptor>
+struct pipeable
+{
+    template <std::ranges::range Range>
+        requires std::invocable<const Adaptor &, Range>
+    friend constexpr auto operator|(Range && range, const Adaptor & adaptor)
+    {
+        return adaptor(std::forward<Range>(range));
+    }
+};
+
+/**
+ * The 'zpp::views::values' adaptor.
+ */
+struct values_adaptor : pipeable<values_adaptor>
+{
+    template <std::ranges::viewable_range Range>
+    constexpr auto operator()(Range && range) const
+    {
+        return std::views::all(std::forward<Range>(range)) |
+               std::views::filter(has_value{}) |
+               std::views::transform(
+                   value_of<movable_elements<Range>>{});
+    }
+};
+
+/**
+ * The 'zpp::views::errors' adaptor.
+ */
+struct errors_adaptor : pipeable<errors_adaptor>
+{
+    template <std::ranges::viewable_range Range>
+    constexpr auto operator()(Range && range) const
+    {
+        return std::views::all(std::forward<Range>(range)) |
+               std::views::filter(has_error{}) |
+               std::views::transform(error_of{});
+    }
+};
+
+/**
+ * The 'zpp::collect' algorithm.
+ */
+struct collect_adaptor : pipeable<collect_adaptor>
+{
+    template <std::ranges::input_range Range>
+    constexpr auto operator()(Range && range) const
+    {
+        using maybe_type = std::remove_cvref_t<
+            std::ranges::range_reference_t<Range>>;
+        using type = typename maybe_type::type;
+        using payload_type = typename maybe_type::payload_type;
+
+        static_assert(!std::is_reference_v<type>,
+                      "References cannot be collected into a vector, "
+                      "iterate zpp::views::values instead.");
+
+        // Without values, only the first error is of interest.
+        if constexpr (std::is_void_v<type>) {
+            for (auto && element : range) {
+                if (!element) ZPP_MAYBE_UNLIKELY {
+                    return zpp::maybe<void, payload_type>(element.error());
+                }
+            }
+            return zpp::maybe<void, payload_type>();
+        } else {
+            return collect_values<type, payload_type>(
+                std::forward<Range>(range));
+        }
+    }
+
+private:
+    template <typename Type, typename Payload, typename Range>
+    static constexpr auto collect_values(Range && range)
+    {
+        using result_type = zpp::maybe<std::vector<Type>, Payload>;
+
+        std::vector<Type> values;
+        if constexpr (std::ranges::sized_range<Range>) {
+            values.reserve(std::ranges::size(range));
+        }
+
+        for (auto && element : range) {
+            if (!element) ZPP_MAYBE_UNLIKELY {
+                return result_type(element.error());
+            }
+
+            if constexpr (movable_elements<Range>) {
+                values.push_back(std::move(element).value());
+            } else {
+                values.push_back(
+                    std::forward<decltype(element)>(element).value());
+            }
+        }
+
+        return result_type(std::move(values));
+    }
+};
+} // namespace ranges_detail
+
+/**
+ * Lazy range adaptors over ranges of maybe.
+ */
+namespace views
+{
+/**
+ * Views the values of the elements that hold one, skipping those that
+ * hold an error. Elements of rvalue ranges are moved from, such views
+ * are meant to be traversed once.
+ *
+ * Example:
+ * ~~~
+ * for (auto & value : results | zpp::views::values) {
+ *     // ...
+ * }
+ * ~~~
+ */
+inline constexpr ranges_detail::values_adaptor values{};
+
+/**
+ * Views the errors of the elements that hold one, skipping those that
+ * hold a value.
+ *
+ * Example:
+ * ~~~
+ * for (auto error : results | zpp::views::errors) {
+ *     std::cout << error.message() << '\n';
+ * }
+ * ~~~
+ */
+inline constexpr ranges_detail::errors_adaptor errors{};
+} // namespace views
+
+/**
+ * Collects the values of a range of maybe into a vector, or returns
+ * the first error. The vector is reserved once from sized ranges, and
+ * the values of rvalue ranges are moved into it. Ranges of
+ * 'zpp::maybe<void>' collect into 'zpp::maybe<void>', which holds the
+ * first error if any. Ranges of 'zpp::maybe<Type &>' are rejected.
+ *
+ * Example:
+ * ~~~
+ * zpp::maybe<std::vector<int>> values = zpp::collect(std::move(results));
+ * ~~~
+ */
+inline constexpr ranges_detail::collect_adaptor collect{};
+} // namespace zpp
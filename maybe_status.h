@@ -0,0 +1,170 @@
+#pragma once
+#include "maybe.h"
+#include <optional>
+#include <type_traits>
+#include <utility>
+
+namespace zpp
+{
+/**
+ * Implementation details of the thread local status.
+ */
+namespace status_detail
+{
+/**
+ * Returns the status of the calling thread, the first error recorded
+ * since the innermost status scope began, if any.
+ */
+inline std::optional<error_detail::error> & current() noexcept
+{
+    thread_local std::optional<error_detail::error> status;
+    return status;
+}
+} // namespace status_detail
+
+/**
+ * Records a failure into the status of the calling thread, for
+ * functions that return plain values inside a 'zpp::status_scope'.
+ * Only the first failure is kept, later ones are ignored, and error
+ * payloads are not kept. Success codes are not failures and are ignored
+ * as well, so that results may be recorded unconditionally.
+ */
+ZPP_MAYBE_COLD inline void fail(const error_detail::error & other) noexcept
+{
+    if (other) {
+        return;
+    }
+
+    auto & status = status_detail::current();
+    if (!status) {
+        status.emplace(other);
+    }
+}
+
+/**
+ * Returns true if a failure was recorded into the status of the calling
+ * thread since the innermost status scope began.
+ */
+inline bool failed() noexcept
+{
+    return status_detail::current().has_value();
+}
+
+/**
+ * Returns the value of the given maybe, or records its error into the
+ * status of the calling thread and returns the fallback value, to call
+ * functions that return 'zpp::maybe' inside a 'zpp::status_scope'.
+ */
+template <typename Type, typename Payload, typename Fallback>
+Type value_or_fail(maybe<Type, Payload> && maybe, Fallback && fallback)
+{
+    if (maybe) ZPP_MAYBE_LIKELY {
+        return std::move(maybe).value();
+    }
+    zpp::fail(maybe.error());
+    return Type(std::forward<Fallback>(fallback));
+}
+
+/**
+ * Starts a fresh thread local status, into which functions record
+ * failures using 'zpp::fail()' rather than returning 'zpp::maybe', so
+ * that tight loops check for failure once per batch using
+ * 'zpp::failed()' instead of once per element. The status of the
+ * enclosing scope is restored when the scope ends.
+ *
+ * Example:
+ * ~~~
+ * std::uint8_t decode(std::uint8_t byte)
+ * {
+ *     if (byte > 127) ZPP_MAYBE_UNLIKELY {
+ *         zpp::fail(my_error::bad_byte);
+ *         return 0;
+ *     }
+ *     return byte;
+ * }
+ *
+ * zpp::maybe<std::size_t> decode_all(range input, std::uint8_t * output)
+ * {
+ *     zpp::status_scope status;
+ *     for (auto byte : input) {
+ *         *output++ = decode(byte);
+ *     }
+ *     return status.result(input.size());
+ * }
+ * ~~~
+ */
+class status_scope
+{
+public:
+    /**
+     * Saves the status of the enclosing scope and starts a fresh one.
+     */
+    status_scope() noexcept : m_enclosing(status_detail::current())
+    {
+        status_detail::current().reset();
+    }
+
+    /**
+     * Restores the status of the enclosing scope, dropping any failure
+     * recorded within this scope.
+     */
+    ~status_scope()
+    {
+        status_detail::current() = m_enclosing;
+    }
+
+    /**
+     * Disables copy and move, the status scope is tied to the thread.
+     */
+    status_scope(const status_scope &) = delete;
+    status_scope & operator=(const status_scope &) = delete;
+
+    /**
+     * Returns true if a failure was recorded within this scope.
+     */
+    bool failed() const noexcept
+    {
+        return zpp::failed();
+    }
+
+    /**
+     * Returns the first error recorded within this scope, a failure
+     * must have been recorded.
+     */
+    zpp::error error() const noexcept
+    {
+        return *status_detail::current();
+    }
+
+    /**
+     * Returns the given value if no failure was recorded within this
+     * scope, otherwise the first error that was recorded.
+     */
+    template <typename Type>
+    zpp::maybe<std::remove_cv_t<std::remove_reference_t<Type>>>
+    result(Type && value) const
+    {
+        using result_type =
+            zpp::maybe<std::remove_cv_t<std::remove_reference_t<Type>>>;
+        auto & status = status_detail::current();
+        if (status) ZPP_MAYBE_UNLIKELY {
+            return result_type(*status);
+        }
+        return result_type(std::forward<Type>(value));
+    }
+
+    /**
+     * Clears the failure recorded within this scope.
+     */
+    void clear() noexcept
+    {
+        status_detail::current().reset();
+    }
+
+private:
+    /**
+     * The status of the enclosing scope.
+     */
+    std::optional<zpp::error> m_enclosing;
+};
+} // namespace zpp
@@ -0,0 +1,438 @@
+#pragma once
+#include "maybe.h"
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <type_traits>
+
+namespace zpp
+{
+/**
+ * The error codes of the operating system, as reported by system
+ * calls, which on POSIX systems are 'errno' values. The portable
+ * 'errno' values, the generic category, are 'std::errc'.
+ */
+enum class system_error : int
+{
+    success = 0,
+};
+
+/**
+ * Implementation details of the system error categories.
+ */
+namespace system_detail
+{
+/**
+ * The messages of the portable 'errno' values.
+ */
+inline constexpr error_message<std::errc> messages[] = {
+    {std::errc::address_family_not_supported,
+     "Address family not supported by protocol"},
+    {std::errc::address_in_use, "Address already in use"},
+    {std::errc::address_not_available, "Cannot assign requested address"},
+    {std::errc::already_connected,
+     "Transport endpoint is already connected"},
+    {std::errc::argument_list_too_long, "Argument list too long"},
+    {std::errc::argument_out_of_domain, "Numerical argument out of domain"},
+    {std::errc::bad_address, "Bad address"},
+    {std::errc::bad_file_descriptor, "Bad file descriptor"},
+    {std::errc::bad_message, "Bad message"},
+    {std::errc::broken_pipe, "Broken pipe"},
+    {std::errc::connection_aborted, "Software caused connection abort"},
+    {std::errc::connection_already_in_progress,
+     "Operation already in progress"},
+    {std::errc::connection_refused, "Connection refused"},
+    {std::errc::connection_reset, "Connection reset by peer"},
+    {std::errc::cross_device_link, "Invalid cross-device link"},
+    {std::errc::destination_address_required,
+     "Destination address required"},
+    {std::errc::device_or_resource_busy, "Device or resource busy"},
+    {std::errc::directory_not_empty, "Directory not empty"},
+    {std::errc::executable_format_error, "Exec format error"},
+    {std::errc::file_exists, "File exists"},
+    {std::errc::file_too_large, "File too large"},
+    {std::errc::filename_too_long, "File name too long"},
+    {std::errc::function_not_supported, "Function not implemented"},
+    {std::errc::host_unreachable, "No route to host"},
+    {std::errc::identifier_removed, "Identifier removed"},
+    {std::errc::illegal_byte_sequence,
+     "Invalid or incomplete multibyte or wide character"},
+    {std::errc::inappropriate_io_control_operation,
+     "Inappropriate ioctl for device"},
+    {std::errc::interrupted, "Interrupted system call"},
+    {std::errc::invalid_argument, "Invalid argument"},
+    {std::errc::invalid_seek, "Illegal seek"},
+    {std::errc::io_error, "Input/output error"},
+    {std::errc::is_a_directory, "Is a directory"},
+    {std::errc::message_size, "Message too long"},
+    {std::errc::network_down, "Network is down"},
+    {std::errc::network_reset, "Network dropped connection on reset"},
+    {std::errc::network_unreachable, "Network is unreachable"},
+    {std::errc::no_buffer_space, "No buffer space available"},
+    {std::errc::no_child_process, "No child processes"},
+    {std::errc::no_link, "Link has been severed"},
+    {std::errc::no_lock_available, "No locks available"},
+    {std::errc::no_message, "No message of desired type"},
+    {std::errc::no_protocol_option, "Protocol not available"},
+    {std::errc::no_space_on_device, "No space left on device"},
+    {std::errc::no_such_device_or_address, "No such device or address"},
+    {std::errc::no_such_device, "No such device"},
+    {std::errc::no_such_file_or_directory, "No such file or directory"},
+    {std::errc::no_such_process, "No such process"},
+    {std::errc::not_a_directory, "Not a directory"},
+    {std::errc::not_a_socket, "Socket operation on non-socket"},
+    {std::errc::not_connected, "Transport endpoint is not connected"},
+    {std::errc::not_enough_memory, "Cannot allocate memory"},
+    {std::errc::not_supported, "Operation not supported"},
+    {std::errc::operation_canceled, "Operation canceled"},
+    {std::errc::operation_in_progress, "Operation now in progress"},
+    {std::errc::operation_not_permitted, "Operation not permitted"},
+    {std::errc::operation_not_supported, "Operation not supported"},
+    {std::errc::operation_would_block,
+     "Resource temporarily unavailable"},
+    {std::errc::owner_dead, "Owner died"},
+    {std::errc::permission_denied, "Permission denied"},
+    {std::errc::protocol_error, "Protocol error"},
+    {std::errc::protocol_not_supported, "Protocol not supported"},
+    {std::errc::read_only_file_system, "Read-only file system"},
+    {std::errc::resource_deadlock_would_occur, "Resource deadlock avoided"},
+    {std::errc::resource_unavailable_try_again,
+     "Resource temporarily unavailable"},
+    {std::errc::result_out_of_range, "Numerical result out of range"},
+    {std::errc::state_not_recoverable, "State not recoverable"},
+    {std::errc::text_file_busy, "Text file busy"},
+    {std::errc::timed_out, "Connection timed out"},
+    {std::errc::too_many_files_open_in_system,
+     "Too many open files in system"},
+    {std::errc::too_many_files_open, "Too many open files"},
+    {std::errc::too_many_links, "Too many links"},
+    {std::errc::too_many_symbolic_link_levels,
+     "Too many levels of symbolic links"},
+    {std::errc::value_too_large, "Value too large for defined data type"},
+    {std::errc::wrong_protocol_type, "Protocol wrong type for socket"},
+};
+
+/**
+ * Returns the largest 'errno' value in the message table.
+ */
+constexpr int max_code() noexcept
+{
+    int max = 0;
+    for (auto & message : messages) {
+        if (int(message.code) > max) {
+            max = int(message.code);
+        }
+    }
+    return max;
+}
+
+/**
+ * The messages of the portable 'errno' values indexed by value, so that
+ * translating a value is a bounds checked load. Values that alias
+ * each other on the platform keep the first message, and zero, which
+ * is success, has no message.
+ */
+template <std::size_t Size>
+class message_table
+{
+public:
+    constexpr message_table() noexcept
+    {
+        for (auto & message : messages) {
+            auto & entry = m_messages[int(message.code)];
+            if (entry.empty()) {
+                entry = message.message;
+            }
+        }
+    }
+
+    /**
+     * Returns the message of the given value.
+     */
+    constexpr std::string_view operator[](int code) const noexcept
+    {
+        if (!code) {
+            return error::no_error;
+        }
+        if (std::size_t(code) < Size && !m_messages[code].empty()) {
+            return m_messages[code];
+        }
+        return error_detail::unknown_error;
+    }
+
+private:
+    /**
+     * The messages, empty for unknown values.
+     */
+    std::string_view m_messages[Size]{};
+};
+
+/**
+ * The messages of the portable 'errno' values.
+ */
+inline constexpr message_table<max_code() + 1> table{};
+
+/**
+ * An error code enumeration for codes of categories that are given
+ * explicitly.
+ */
+enum class raw_code : int
+{
+};
+
+/**
+ * Exposes a category of 'zpp::error' as a 'std::error_category'.
+ */
+class std_category final : public std::error_category
+{
+public:
+    const char * name() const noexcept override
+    {
+        // The name is copied after the slot is claimed, and is ready
+        // once the identifier is published.
+        if (m_id.load(std::memory_order_acquire)) ZPP_MAYBE_LIKELY {
+            return m_name;
+        }
+        return "zpp::error_category";
+    }
+
+    std::string message(int code) const override
+    {
+        if (auto category = m_category.load(std::memory_order_acquire)) {
+            return std::string(category->message(code));
+        }
+        return std::string(error_detail::unknown_error);
+    }
+
+    /**
+     * Returns the category, or null if the slot is free.
+     */
+    const zpp::error_category * category() const noexcept
+    {
+        return m_category.load(std::memory_order_acquire);
+    }
+
+    /**
+     * The identifier of the category, zero until the name is copied.
+     */
+    std::atomic<std::uint32_t> m_id{};
+
+    /**
+     * The category, null if the slot is free.
+     */
+    std::atomic<const zpp::error_category *> m_category{};
+
+    /**
+     * The null terminated name of the category, truncated if needed.
+     */
+    char m_name[64]{};
+};
+
+/**
+ * A fixed capacity table of the 'std::error_category' adapters of the
+ * categories of 'zpp::error', so that converting to 'std::error_code'
+ * never allocates. A slot is claimed by a single compare and swap of
+ * the category, and its identifier is published after the name is
+ * copied, like the category registry, so that neither finding nor
+ * adding an adapter waits. A single adapter per category is kept so
+ * that the resulting error codes compare equal.
+ */
+class std_categories
+{
+public:
+    /**
+     * The capacity of the table.
+     */
+    static constexpr std::uint32_t capacity =
+        ZPP_MAYBE_MAX_ERROR_CATEGORIES;
+
+    /**
+     * Returns the adapter of the given category, or the adapter of
+     * unknown categories if the table is full.
+     */
+    static const std::error_category &
+    get(const zpp::error_category & category) noexcept
+    {
+        auto id = category.id();
+        for (std::uint32_t probe = 0; probe != capacity; ++probe) {
+            auto & slot = s_slots[(id + probe) & (capacity - 1)];
+            auto current = slot.m_id.load(std::memory_order_acquire);
+            if (current == id) ZPP_MAYBE_LIKELY {
+                return slot;
+            }
+            if (current) {
+                continue;
+            }
+
+            // The slot is free, or claimed but its name is not yet
+            // copied, in which case its category tells whether it is
+            // the adapter of this category.
+            auto claimed = slot.category();
+            if (!claimed &&
+                slot.m_category.compare_exchange_strong(
+                    claimed,
+                    std::addressof(category),
+                    std::memory_order_acq_rel,
+                    std::memory_order_acquire)) {
+                auto name = category.name();
+                auto size = std::min(name.size(), sizeof(slot.m_name) - 1);
+                name.copy(slot.m_name, size);
+                slot.m_name[size] = '\0';
+                slot.m_id.store(id, std::memory_order_release);
+                return slot;
+            }
+            if (claimed->id() == id) {
+                return slot;
+            }
+        }
+        return s_unknown;
+    }
+
+    /**
+     * Returns the category of the given adapter, or null if it is not
+     * an adapter from this table.
+     */
+    static const zpp::error_category *
+    find(const std::error_category & category) noexcept
+    {
+        auto address = static_cast<const void *>(std::addressof(category));
+        if (std::less<const void *>{}(address, s_slots) ||
+            !std::less<const void *>{}(address, s_slots + capacity)) {
+            return nullptr;
+        }
+        return static_cast<const std_category &>(category).category();
+    }
+
+private:
+    /**
+     * The slots.
+     */
+    inline static std_category s_slots[capacity]{};
+
+    /**
+     * The adapter of unknown categories.
+     */
+    inline static std_category s_unknown{};
+};
+} // namespace system_detail
+
+/**
+ * The generic error category, of the portable 'errno' values.
+ */
+template <>
+inline constexpr auto define_error_category<std::errc> =
+    make_error_category("zpp::generic_error",
+                        std::errc{},
+                        [](std::errc code) -> std::string_view {
+                            return system_detail::table[int(code)];
+                        });
+
+/**
+ * The system error category, of the error codes reported by the
+ * operating system.
+ */
+template <>
+inline constexpr auto define_error_category<system_error> =
+    make_error_category("zpp::system_error",
+                        system_error::success,
+                        [](system_error code) -> std::string_view {
+#ifdef _WIN32
+                            if (code == system_error::success) {
+                                return error::no_error;
+                            }
+                            return error_detail::unknown_error;
+#else
+                            return system_detail::table[int(code)];
+#endif
+                        });
+
+/**
+ * Returns the error of the given 'errno' value, the current 'errno'
+ * value by default, in the generic category. The category is known at
+ * compile time so no lookup takes place.
+ *
+ * Example:
+ * ~~~
+ * if (::read(fd, buffer, size) < 0) {
+ *     return zpp::from_errno();
+ * }
+ * ~~~
+ */
+inline error
+from_errno(int code = errno ZPP_MAYBE_SAMPLE_LOCATION_PARAMETER) noexcept
+{
+    return error(std::errc(code) ZPP_MAYBE_SAMPLE_LOCATION_ARGUMENT);
+}
+
+/**
+ * Converts the error to a 'std::error_code', without allocating.
+ * The generic and system categories map to 'std::generic_category()'
+ * and 'std::system_category()', other categories are exposed through
+ * an adapter per category that 'zpp::from_error_code()' maps back.
+ */
+inline std::error_code to_error_code(const error & other) noexcept
+{
+    auto id = other.category_id();
+    if (id == category<std::errc>().id()) ZPP_MAYBE_LIKELY {
+        return std::error_code(other.code(), std::generic_category());
+    }
+    if (id == category<system_error>().id()) {
+        return std::error_code(other.code(), std::system_category());
+    }
+    return std::error_code(other.code(),
+                           system_detail::std_categories::get(
+                               other.category()));
+}
+
+/**
+ * Converts the 'std::error_code' to an error, without allocating.
+ * The generic and system categories map to 'std::errc' and
+ * 'zpp::system_error', adapters made by 'zpp::to_error_code()' map back
+ * to their categories, and other codes map to their default error
+ * condition if it is generic, or to 'std::errc::io_error' otherwise.
+ */
+inline error from_error_code(const std::error_code & code) noexcept
+{
+    auto & category = code.category();
+    if (category == std::generic_category()) ZPP_MAYBE_LIKELY {
+        return std::errc(code.value());
+    }
+    if (category == std::system_category()) {
+        return system_error(code.value());
+    }
+    if (auto original = system_detail::std_categories::find(category)) {
+        return error(system_detail::raw_code(code.value()), *original);
+    }
+    if (!code) {
+        return std::errc{};
+    }
+    auto condition = code.default_error_condition();
+    if (condition.category() == std::generic_category()) {
+        return std::errc(condition.value());
+    }
+    return std::errc::io_error;
+}
+
+/**
+ * Makes 'zpp::system_error' implicitly convertible to
+ * 'std::error_code'.
+ */
+inline std::error_code make_error_code(system_error code) noexcept
+{
+    return std::error_code(int(code), std::system_category());
+}
+} // namespace zpp
+
+/**
+ * Marks 'zpp::system_error' as an error code enumeration.
+ */
+template <>
+struct std::is_error_code_enum<zpp::system_error> : std::true_type
+{
+};
@@ -0,0 +1,643 @@
+#pragma once
+#include "maybe.h"
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace zpp
+{
+/**
+ * Implementation details of the structure of arrays maybe containers.
+ */
+namespace maybe_vector_detail
+{
+/**
+ * The number of bits in a bitmap word.
+ */
+inline constexpr std::size_t word_bits = 64;
+
+/**
+ * Returns the number of set bits in the given word.
+ */
+constexpr int popcount(std::uint64_t word) noexcept
+{
+#if defined(__GNUC__) || defined(__clang__)
+    return __builtin_popcountll(word);
+#else
+    int count = 0;
+    for (; word; word &= word - 1) {
+        ++count;
+    }
+    return count;
+#endif
+}
+
+/**
+ * Returns the index of the lowest set bit of a non zero word.
+ */
+constexpr int countr_zero(std::uint64_t word) noexcept
+{
+#if defined(__GNUC__) || defined(__clang__)
+    return __builtin_ctzll(word);
+#else
+    int count = 0;
+    for (; !(word & 1); word >>= 1) {
+        ++count;
+    }
+    return count;
+#endif
+}
+
+/**
+ * A contiguous range of objects.
+ */
+template <typename Type>
+class range
+{
+public:
+    constexpr range(Type * first, Type * last) noexcept :
+        m_first(first), m_last(last)
+    {
+    }
+
+    constexpr Type * begin() const noexcept
+    {
+        return m_first;
+    }
+
+    constexpr Type * end() const noexcept
+    {
+        return m_last;
+    }
+
+    constexpr std::size_t size() const noexcept
+    {
+        return std::size_t(m_last - m_first);
+    }
+
+    constexpr bool empty() const noexcept
+    {
+        return m_first == m_last;
+    }
+
+private:
+    Type * m_first{};
+    Type * m_last{};
+};
+} // namespace maybe_vector_detail
+
+/**
+ * An error stored in a maybe vector, along with the index of
+ * the element it belongs to.
+ */
+struct indexed_error
+{
+    /**
+     * The element index.
+     */
+    std::size_t index;
+
+    /**
+     * The error of the element.
+     */
+    zpp::error error;
+};
+
+/**
+ * A non owning view of a structure of arrays sequence of maybe objects,
+ * see 'maybe_vector'.
+ */
+template <typename Type>
+class maybe_span
+{
+public:
+    /**
+     * The type of value.
+     */
+    using type = std::remove_const_t<Type>;
+
+    /**
+     * Constructs a maybe span from the values, the success bitmap
+     * where a set bit denotes a value, and the errors sorted by index.
+     * Bits of the last bitmap word beyond the size must be zero.
+     */
+    constexpr maybe_span(Type * values,
+                         const std::uint64_t * bitmap,
+                         std::size_t size,
+                         const indexed_error * errors,
+                         std::size_t error_count) noexcept :
+        m_values(values),
+        m_bitmap(bitmap),
+        m_size(size),
+        m_errors(errors),
+        m_error_count(error_count)
+    {
+    }
+
+    /**
+     * Returns the number of elements.
+     */
+    constexpr std::size_t size() const noexcept
+    {
+        return m_size;
+    }
+
+    /**
+     * Returns true if there are no elements.
+     */
+    constexpr bool empty() const noexcept
+    {
+        return !m_size;
+    }
+
+    /**
+     * Returns true if the element at the given index holds a value.
+     */
+    constexpr bool ok(std::size_t index) const noexcept
+    {
+        return (m_bitmap[index / maybe_vector_detail::word_bits] >>
+                (index % maybe_vector_detail::word_bits)) &
+               1;
+    }
+
+    /**
+     * Returns the value at the given index.
+     * The behavior is undefined if the element holds an error.
+     */
+    constexpr Type & value(std::size_t index) const noexcept
+    {
+        return m_values[index];
+    }
+
+    /**
+     * Returns the error at the given index, or the success code of
+     * 'zpp::maybe_error' if the element holds a value.
+     */
+    constexpr zpp::error error(std::size_t index) const noexcept
+    {
+        std::size_t first = 0;
+        std::size_t last = m_error_count;
+        while (first < last) {
+            auto middle = first + (last - first) / 2;
+            if (m_errors[middle].index < index) {
+                first = middle + 1;
+            } else {
+                last = middle;
+            }
+        }
+        if (first == m_error_count || m_errors[first].index != index)
+            ZPP_MAYBE_UNLIKELY {
+            return maybe_error::success;
+        }
+        return m_errors[first].error;
+    }
+
+    /**
+     * Returns the element at the given index as a maybe.
+     */
+    constexpr maybe<type> get(std::size_t index) const
+    {
+        if (ok(index)) {
+            return maybe<type>(std::in_place, m_values[index]);
+        }
+        return error(index);
+    }
+
+    /**
+     * Returns true if all elements hold values.
+     * Scans the success bitmap in a loop that compilers vectorize.
+     */
+    constexpr bool all_ok() const noexcept
+    {
+        auto full_words = m_size / maybe_vector_detail::word_bits;
+        std::uint64_t all = ~std::uint64_t{};
+        for (std::size_t i = 0; i < full_words; ++i) {
+            all &= m_bitmap[i];
+        }
+        if (all != ~std::uint64_t{}) {
+            return false;
+        }
+        auto tail = m_size % maybe_vector_detail::word_bits;
+        if (!tail) {
+            return true;
+        }
+        auto mask = (std::uint64_t(1) << tail) - 1;
+        return (m_bitmap[full_words] & mask) == mask;
+    }
+
+    /**
+     * Returns the number of elements that hold errors.
+     * Counts the success bitmap in a loop that compilers vectorize.
+     */
+    constexpr std::size_t count_errors() const noexcept
+    {
+        auto words = (m_size + maybe_vector_detail::word_bits - 1) /
+                     maybe_vector_detail::word_bits;
+        std::size_t successes = 0;
+        for (std::size_t i = 0; i < words; ++i) {
+            successes +=
+                std::size_t(maybe_vector_detail::popcount(m_bitmap[i]));
+        }
+        return m_size - successes;
+    }
+
+    /**
+     * Returns the contiguous range of all value slots, including those
+     * of elements that hold errors, which hold value initialized
+     * objects.
+     */
+    constexpr maybe_vector_detail::range<Type> values() const noexcept
+    {
+        return {m_values, m_values + m_size};
+    }
+
+    /**
+     * Returns the range of errors, sorted by index.
+     */
+    constexpr maybe_vector_detail::range<const indexed_error>
+    errors() const noexcept
+    {
+        return {m_errors, m_errors + m_error_count};
+    }
+
+    /**
+     * Calls the given function with the index and value of every
+     * element that holds a value, skipping errors a word at a time.
+     */
+    template <typename Function>
+    constexpr void for_each_value(Function && function) const
+    {
+        auto words = (m_size + maybe_vector_detail::word_bits - 1) /
+                     maybe_vector_detail::word_bits;
+        for (std::size_t i = 0; i < words; ++i) {
+            for (auto word = m_bitmap[i]; word; word &= word - 1) {
+                auto index =
+                    i * maybe_vector_detail::word_bits +
+                    std::size_t(maybe_vector_detail::countr_zero(word));
+                function(index, m_values[index]);
+            }
+        }
+    }
+
+private:
+    Type * m_values{};
+    const std::uint64_t * m_bitmap{};
+    std::size_t m_size{};
+    const indexed_error * m_errors{};
+    std::size_t m_error_count{};
+};
+
+/**
+ * A sequence of maybe objects stored as a structure of arrays - the
+ * values are stored contiguously, a packed bitmap denotes which elements
+ * hold values, and errors are stored in a sparse side table, sorted by
+ * index. This avoids interleaving errors with values so that passes over
+ * the values and the success bitmap run at memory bandwidth.
+ * Elements that hold errors occupy a value initialized value slot, hence
+ * the value type must be default constructible. If appending throws,
+ * the vector is left unchanged.
+ * Example:
+ * ~~~
+ * zpp::maybe_vector<int> results;
+ * for (auto & row : rows) {
+ *     results.push_back(parse(row));
+ * }
+ *
+ * if (!results.all_ok()) {
+ *     for (auto & [index, error] : results.errors()) {
+ *         report(index, error);
+ *     }
+ * }
+ * ~~~
+ */
+template <typename Type>
+class maybe_vector
+{
+public:
+    static_assert(std::is_default_constructible_v<Type>,
+                  "The value type must be default constructible.");
+    static_assert(!std::is_same_v<std::remove_cv_t<Type>, bool>,
+                  "The values are stored contiguously, which "
+                  "'std::vector<bool>' does not do, use 'std::uint8_t'.");
+
+    /**
+     * The type of value.
+     */
+    using type = Type;
+
+    /**
+     * Constructs an empty maybe vector.
+     */
+    maybe_vector() = default;
+
+    /**
+     * Reserves space for the given number of elements, and
+     * optionally errors.
+     */
+    void reserve(std::size_t size, std::size_t errors = 0)
+    {
+        m_values.reserve(size);
+        m_bitmap.reserve((size + maybe_vector_detail::word_bits - 1) /
+                         maybe_vector_detail::word_bits);
+        m_errors.reserve(errors);
+    }
+
+    /**
+     * Appends a value.
+     */
+    void push_back(const Type & value)
+    {
+        emplace_back(value);
+    }
+
+    /**
+     * Appends a value.
+     */
+    void push_back(Type && value)
+    {
+        emplace_back(std::move(value));
+    }
+
+    /**
+     * Appends an error.
+     */
+    void push_back(const zpp::error & other)
+    {
+        reserve_one(m_errors);
+        reserve_bit();
+        m_values.emplace_back();
+        m_errors.push_back({m_values.size() - 1, other});
+        append_bit(false);
+    }
+
+    /**
+     * Appends the value or error of the given maybe.
+     */
+    void push_back(const maybe<Type> & maybe)
+    {
+        if (maybe) {
+            emplace_back(maybe.value());
+        } else {
+            push_back(maybe.error());
+        }
+    }
+
+    /**
+     * Appends the value or error of the given maybe.
+     */
+    void push_back(maybe<Type> && maybe)
+    {
+        if (maybe) {
+            emplace_back(std::move(maybe).value());
+        } else {
+            push_back(maybe.error());
+        }
+    }
+
+    /**
+     * Appends a value constructed in place from the given arguments.
+     */
+    template <typename... Arguments>
+    Type & emplace_back(Arguments &&... arguments)
+    {
+        reserve_bit();
+        auto & value =
+            m_values.emplace_back(std::forward<Arguments>(arguments)...);
+        append_bit(true);
+        return value;
+    }
+
+    /**
+     * Removes all elements.
+     */
+    void clear() noexcept
+    {
+        m_values.clear();
+        m_bitmap.clear();
+        m_errors.clear();
+    }
+
+    /**
+     * Returns the number of elements.
+     */
+    std::size_t size() const noexcept
+    {
+        return m_values.size();
+    }
+
+    /**
+     * Returns true if there are no elements.
+     */
+    bool empty() const noexcept
+    {
+        return m_values.empty();
+    }
+
+    /**
+     * Returns true if the element at the given index holds a value.
+     */
+    bool ok(std::size_t index) const noexcept
+    {
+        return span().ok(index);
+    }
+
+    /**
+     * Returns the value at the given index.
+     * The behavior is undefined if the element holds an error.
+     */
+    Type & value(std::size_t index) noexcept
+    {
+        return m_values[index];
+    }
+
+    /**
+     * Returns the value at the given index.
+     * The behavior is undefined if the element holds an error.
+     */
+    const Type & value(std::size_t index) const noexcept
+    {
+        return m_values[index];
+    }
+
+    /**
+     * Returns the error at the given index, or the success code of
+     * 'zpp::maybe_error' if the element holds a value.
+     */
+    zpp::error error(std::size_t index) const noexcept
+    {
+        return span().error(index);
+    }
+
+    /**
+     * Returns the element at the given index as a maybe.
+     */
+    maybe<Type> get(std::size_t index) const
+    {
+        return span().get(index);
+    }
+
+    /**
+     * Returns true if all elements hold values.
+     */
+    bool all_ok() const noexcept
+    {
+        return m_errors.empty();
+    }
+
+    /**
+     * Returns the number of elements that hold errors.
+     */
+    std::size_t count_errors() const noexcept
+    {
+        return m_errors.size();
+    }
+
+    /**
+     * Returns the contiguous range of all value slots, including those
+     * of elements that hold errors, which hold value initialized
+     * objects.
+     */
+    maybe_vector_detail::range<Type> values() noexcept
+    {
+        return {m_values.data(), m_values.data() + m_values.size()};
+    }
+
+    /**
+     * Returns the contiguous range of all value slots, including those
+     * of elements that hold errors, which hold value initialized
+     * objects.
+     */
+    maybe_vector_detail::range<const Type> values() const noexcept
+    {
+        return {m_values.data(), m_values.data() + m_values.size()};
+    }
+
+    /**
+     * Returns the range of errors, sorted by index.
+     */
+    maybe_vector_detail::range<const indexed_error> errors() const noexcept
+    {
+        return {m_errors.data(), m_errors.data() + m_errors.size()};
+    }
+
+    /**
+     * Calls the given function with the index and value of every
+     * element that holds a value.
+     */
+    template <typename Function>
+    void for_each_value(Function && function)
+    {
+        span().for_each_value(std::forward<Function>(function));
+    }
+
+    /**
+     * Calls the given function with the index and value of every
+     * element that holds a value.
+     */
+    template <typename Function>
+    void for_each_value(Function && function) const
+    {
+        span().for_each_value(std::forward<Function>(function));
+    }
+
+    /**
+     * Returns a view of the elements.
+     */
+    maybe_span<Type> span() noexcept
+    {
+        return {m_values.data(),
+                m_bitmap.data(),
+                m_values.size(),
+                m_errors.data(),
+                m_errors.size()};
+    }
+
+    /**
+     * Returns a view of the elements.
+     */
+    maybe_span<const Type> span() const noexcept
+    {
+        return {m_values.data(),
+                m_bitmap.data(),
+                m_values.size(),
+                m_errors.data(),
+                m_errors.size()};
+    }
+
+    /**
+     * Converts to a view of the elements.
+     */
+    operator maybe_span<Type>() noexcept
+    {
+        return span();
+    }
+
+    /**
+     * Converts to a view of the elements.
+     */
+    operator maybe_span<const Type>() const noexcept
+    {
+        return span();
+    }
+
+private:
+    /**
+     * Makes room for one more element in the given vector, growing it
+     * geometrically, so that the appending that follows does not throw.
+     */
+    template <typename Vector>
+    static void reserve_one(Vector & vector)
+    {
+        if (vector.size() == vector.capacity()) {
+            vector.reserve(std::max<std::size_t>(2 * vector.capacity(), 1));
+        }
+    }
+
+    /**
+     * Makes room in the success bitmap for the bit of the next element,
+     * so that appending the bit does not throw. Elements are appended
+     * by first reserving the success bitmap and the errors, and then
+     * appending the value, so that if anything throws, the three
+     * arrays are left as they were.
+     */
+    void reserve_bit()
+    {
+        if (!(m_values.size() % maybe_vector_detail::word_bits)) {
+            reserve_one(m_bitmap);
+        }
+    }
+
+    /**
+     * Appends a bit to the success bitmap, for the element that was
+     * just appended.
+     */
+    void append_bit(bool success)
+    {
+        auto index = m_values.size() - 1;
+        if (!(index % maybe_vector_detail::word_bits)) {
+            m_bitmap.push_back(0);
+        }
+        m_bitmap.back() |= std::uint64_t(success)
+                           << (index % maybe_vector_detail::word_bits);
+    }
+
+    /**
+     * The values, elements that hold errors have a value initialized
+     * value.
+     */
+    std::vector<Type> m_values;
+
+    /**
+     * The success bitmap, a set bit denotes a value.
+     */
+    std::vector<std::uint64_t> m_bitmap;
+
+    /**
+     * The errors, sorted by index.
+     */
+    std::vector<indexed_error> m_errors;
+};
+} // namespace zpp
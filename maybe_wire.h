@@ -0,0 +1,465 @@
+#pragma once
+#include "maybe.h"
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+#include <string_view>
+#include <type_traits>
+
+namespace zpp
+{
+/**
+ * The errors of the wire format.
+ */
+enum class wire_error : int
+{
+    success = 0,
+    buffer_too_small = 1,
+    bad_format = 2,
+    size_mismatch = 3,
+};
+
+/**
+ * The error category of the wire format.
+ */
+template <>
+inline constexpr auto define_error_category<wire_error> =
+    make_error_category("zpp::wire_error",
+                        wire_error::success,
+                        {
+                            {wire_error::success, error::no_error},
+                            {wire_error::buffer_too_small,
+                             "The buffer is too small."},
+                            {wire_error::bad_format,
+                             "The buffer is not in the wire format."},
+                            {wire_error::size_mismatch,
+                             "The size of the value does not match."},
+                        });
+
+/**
+ * The size of an encoded error, and of the header of an encoded maybe.
+ *
+ * The wire format is little endian, with no padding or alignment
+ * requirement, and is laid out as follows:
+ * ~~~
+ * offset 0:  uint32 - the category identifier, below 2^31, zero for a
+ *                     value.
+ * offset 4:  uint32 - the error code.
+ * offset 8:  uint32 - flags, bit 0 is set for success codes.
+ * offset 12: uint32 - the size of the value that follows.
+ * offset 16: the value, if there is one.
+ * ~~~
+ * Integral, enumeration and floating point values are stored in little
+ * endian order, other trivially copyable values are stored as their
+ * object representation, which must agree between the two sides.
+ */
+inline constexpr std::size_t wire_header_size = 16;
+
+/**
+ * The size of an encoded error.
+ */
+inline constexpr std::size_t error_wire_size = wire_header_size;
+
+/**
+ * The size of an encoded maybe of the given value type.
+ */
+template <typename Type>
+inline constexpr std::size_t maybe_wire_size =
+    wire_header_size + sizeof(Type);
+
+/**
+ * Implementation details of the wire format.
+ */
+namespace wire_detail
+{
+/**
+ * The success flag.
+ */
+inline constexpr std::uint32_t success_flag = 1;
+
+/**
+ * Whether the target is big endian, in which case stored values are
+ * byte swapped.
+ */
+#if defined(__BYTE_ORDER__) && defined(__ORDER_BIG_ENDIAN__) && \
+    __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+inline constexpr bool big_endian = true;
+#else
+inline constexpr bool big_endian = false;
+#endif
+
+/**
+ * Converts the given value between the host order and little
+ * endian order.
+ */
+template <typename Unsigned>
+constexpr Unsigned little_endian(Unsigned value) noexcept
+{
+    if constexpr (big_endian) {
+        Unsigned swapped{};
+        for (std::size_t i = 0; i < sizeof(Unsigned); ++i) {
+            swapped = Unsigned((swapped << 8) | ((value >> (i * 8)) & 0xff));
+        }
+        return swapped;
+    } else {
+        return value;
+    }
+}
+
+/**
+ * Stores the given value in little endian order.
+ */
+template <typename Unsigned>
+void store(unsigned char * data, Unsigned value) noexcept
+{
+    value = little_endian(value);
+    std::memcpy(data, &value, sizeof(value));
+}
+
+/**
+ * Loads a value stored in little endian order.
+ */
+template <typename Unsigned>
+Unsigned load(const unsigned char * data) noexcept
+{
+    Unsigned value;
+    std::memcpy(&value, data, sizeof(value));
+    return little_endian(value);
+}
+
+/**
+ * The unsigned integer type of the given size, used to store
+ * arithmetic values in little endian order, void if there is none.
+ */
+template <std::size_t Size>
+using unsigned_of = std::conditional_t<
+    Size == 1,
+    std::uint8_t,
+    std::conditional_t<
+        Size == 2,
+        std::uint16_t,
+        std::conditional_t<
+            Size == 4,
+            std::uint32_t,
+            std::conditional_t<Size == 8, std::uint64_t, void>>>>;
+
+/**
+ * Whether the given type is stored in little endian order.
+ */
+template <typename Type>
+inline constexpr bool is_little_endian_stored =
+    (std::is_arithmetic_v<Type> || std::is_enum_v<Type>) &&
+    !std::is_void_v<unsigned_of<sizeof(Type)>>;
+
+/**
+ * Stores the given value.
+ */
+template <typename Type>
+void store_value(unsigned char * data, const Type & value) noexcept
+{
+    if constexpr (is_little_endian_stored<Type>) {
+        unsigned_of<sizeof(Type)> bits;
+        std::memcpy(&bits, std::addressof(value), sizeof(value));
+        store(data, bits);
+    } else {
+        std::memcpy(data, std::addressof(value), sizeof(value));
+    }
+}
+
+/**
+ * Loads a stored value. The bytes are copied into a union, which
+ * implicitly creates the trivially copyable value, so that it needs no
+ * default constructor.
+ */
+template <typename Type>
+Type load_value(const unsigned char * data) noexcept
+{
+    union bytes_or_value
+    {
+        bytes_or_value() noexcept : bytes{}
+        {
+        }
+
+        unsigned char bytes[sizeof(Type)];
+        Type value;
+    } storage;
+    if constexpr (is_little_endian_stored<Type>) {
+        auto bits = load<unsigned_of<sizeof(Type)>>(data);
+        std::memcpy(std::addressof(storage.value), &bits, sizeof(Type));
+    } else {
+        std::memcpy(std::addressof(storage.value), data, sizeof(Type));
+    }
+    return storage.value;
+}
+
+/**
+ * Returns the given buffer as bytes.
+ */
+template <typename Buffer>
+auto bytes(Buffer && buffer) noexcept
+{
+    using element = std::remove_pointer_t<decltype(std::data(buffer))>;
+    static_assert(sizeof(element) == 1,
+                  "The buffer must be a contiguous range of bytes.");
+    if constexpr (std::is_const_v<element>) {
+        return reinterpret_cast<const unsigned char *>(std::data(buffer));
+    } else {
+        return reinterpret_cast<unsigned char *>(std::data(buffer));
+    }
+}
+
+/**
+ * Stores the header of the given error.
+ */
+inline void store_error(unsigned char * data, const error & error) noexcept
+{
+    store(data, error.category_id());
+    store(data + 4, std::uint32_t(error.code()));
+    store(data + 8, error ? success_flag : std::uint32_t{});
+    store(data + 12, std::uint32_t{});
+}
+
+/**
+ * Creates errors from their wire representation.
+ */
+struct access
+{
+    /**
+     * Returns the error of the given category identifier and code.
+     * In compact error mode, the identifier is kept as is, otherwise,
+     * an error of a category that is not registered is of the
+     * unregistered category.
+     */
+    static error make(std::uint32_t category_id,
+                      std::uint32_t code,
+                      bool success) noexcept
+    {
+#if ZPP_MAYBE_COMPACT_ERROR
+        return error(error::encoded_category_type((category_id << 1) |
+                                                  (success ? 1 : 0)),
+                     error::encoded_code_type(code));
+#else
+        return error(
+            std::addressof(error_detail::category_registry::at(category_id)),
+            error::encoded_code_type(code) |
+                (success ? error::success_flag : 0));
+#endif
+    }
+};
+} // namespace wire_detail
+
+/**
+ * A view of an error encoded in the wire format, decoded on access.
+ */
+class error_view
+{
+public:
+    /**
+     * Creates a view of the encoded error at the given address, which
+     * must hold at least 'error_wire_size' bytes.
+     */
+    constexpr explicit error_view(const unsigned char * data) noexcept :
+        m_data(data)
+    {
+    }
+
+    /**
+     * Returns the category identifier.
+     */
+    std::uint32_t category_id() const noexcept
+    {
+        return wire_detail::load<std::uint32_t>(m_data);
+    }
+
+    /**
+     * Returns the error code.
+     */
+    int code() const noexcept
+    {
+        return int(wire_detail::load<std::uint32_t>(m_data + 4));
+    }
+
+    /**
+     * Returns true if the error indicates success, else false.
+     */
+    explicit operator bool() const noexcept
+    {
+        return wire_detail::load<std::uint32_t>(m_data + 8) &
+               wire_detail::success_flag;
+    }
+
+    /**
+     * Returns the error, whose category is looked up in the category
+     * registry by identifier, see 'zpp::register_error_category'.
+     */
+    zpp::error error() const noexcept
+    {
+        return wire_detail::access::make(
+            category_id(), std::uint32_t(code()), bool(*this));
+    }
+
+private:
+    /**
+     * The encoded error.
+     */
+    const unsigned char * m_data{};
+};
+
+/**
+ * A view of a maybe encoded in the wire format, decoded on access.
+ */
+template <typename Type>
+class maybe_view
+{
+public:
+    static_assert(std::is_trivially_copyable_v<Type>,
+                  "Only maybe of trivially copyable types is encoded.");
+
+    /**
+     * Creates a view of the encoded maybe at the given address, which
+     * must hold at least 'maybe_wire_size<Type>' bytes.
+     */
+    constexpr explicit maybe_view(const unsigned char * data) noexcept :
+        m_data(data)
+    {
+    }
+
+    /**
+     * Returns true if there is a value, else false.
+     */
+    explicit operator bool() const noexcept
+    {
+        return !wire_detail::load<std::uint32_t>(m_data);
+    }
+
+    /**
+     * Returns the value. The behavior is undefined if there is an
+     * error.
+     */
+    Type value() const noexcept
+    {
+        return wire_detail::load_value<Type>(m_data + wire_header_size);
+    }
+
+    /**
+     * Returns the error. The behavior is undefined if there is a value.
+     */
+    zpp::error error() const noexcept
+    {
+        return zpp::error_view(m_data).error();
+    }
+
+    /**
+     * Returns the decoded maybe.
+     */
+    maybe<Type> get() const noexcept
+    {
+        if (*this) {
+            return maybe<Type>(std::in_place, value());
+        }
+        return error();
+    }
+
+private:
+    /**
+     * The encoded maybe.
+     */
+    const unsigned char * m_data{};
+};
+
+/**
+ * Encodes the given error into the beginning of the given buffer, a
+ * contiguous range of bytes such as 'std::span<std::byte>'. Returns the
+ * number of bytes written, 'error_wire_size'.
+ * No allocation takes place.
+ */
+template <typename Buffer>
+maybe<std::size_t> serialize_into(Buffer && buffer, const error & other)
+{
+    if (std::size(buffer) < error_wire_size) ZPP_MAYBE_UNLIKELY {
+        return wire_error::buffer_too_small;
+    }
+    wire_detail::store_error(wire_detail::bytes(buffer), other);
+    return error_wire_size;
+}
+
+/**
+ * Encodes the given maybe of a trivially copyable type into the
+ * beginning of the given buffer, a contiguous range of bytes. Returns
+ * the number of bytes written, 'maybe_wire_size<Type>', also when there
+ * is an error, in which case the value bytes are zero.
+ * No allocation takes place.
+ */
+template <typename Buffer, typename Type>
+maybe<std::size_t> serialize_into(Buffer && buffer,
+                                  const maybe<Type> & maybe)
+{
+    static_assert(std::is_trivially_copyable_v<Type>,
+                  "Only maybe of trivially copyable types is encoded.");
+    if (std::size(buffer) < maybe_wire_size<Type>) ZPP_MAYBE_UNLIKELY {
+        return wire_error::buffer_too_small;
+    }
+
+    auto data = wire_detail::bytes(buffer);
+    if (maybe) {
+        std::memset(data, 0, wire_header_size);
+        wire_detail::store(data + 12, std::uint32_t(sizeof(Type)));
+        wire_detail::store_value(data + wire_header_size, maybe.value());
+    } else {
+        wire_detail::store_error(data, maybe.error());
+        wire_detail::store(data + 12, std::uint32_t(sizeof(Type)));
+        std::memset(data + wire_header_size, 0, sizeof(Type));
+    }
+    return maybe_wire_size<Type>;
+}
+
+/**
+ * Returns a view of the encoded object of the given type, either
+ * 'zpp::error' or 'zpp::maybe<Type>', at the beginning of the given
+ * buffer. The view refers to the buffer and decodes fields on access,
+ * nothing is copied.
+ * Example:
+ * ~~~
+ * unsigned char buffer[zpp::maybe_wire_size<int>];
+ * zpp::serialize_into(buffer, zpp::maybe<int>(1337));
+ *
+ * if (auto view = zpp::view_from<zpp::maybe<int>>(buffer)) {
+ *     if (view.value()) {
+ *         std::cout << view.value().value() << '\n';
+ *     }
+ * }
+ * ~~~
+ */
+template <typename Object, typename Buffer>
+auto view_from(Buffer && buffer)
+{
+    auto data = wire_detail::bytes(std::as_const(buffer));
+    auto size = std::size(buffer);
+    if constexpr (std::is_same_v<Object, error>) {
+        if (size < error_wire_size) ZPP_MAYBE_UNLIKELY {
+            return maybe<error_view>(wire_error::buffer_too_small);
+        }
+        auto category_id = wire_detail::load<std::uint32_t>(data);
+        if (!category_id || (category_id >> 31)) ZPP_MAYBE_UNLIKELY {
+            return maybe<error_view>(wire_error::bad_format);
+        }
+        return maybe<error_view>(error_view(data));
+    } else {
+        using type = typename Object::type;
+        static_assert(std::is_same_v<Object, maybe<type>>,
+                      "Only 'zpp::error' or 'zpp::maybe' may be viewed.");
+        if (size < maybe_wire_size<type>) ZPP_MAYBE_UNLIKELY {
+            return maybe<maybe_view<type>>(wire_error::buffer_too_small);
+        }
+        if (wire_detail::load<std::uint32_t>(data + 12) != sizeof(type))
+            ZPP_MAYBE_UNLIKELY {
+            return maybe<maybe_view<type>>(wire_error::size_mismatch);
+        }
+        if (wire_detail::load<std::uint32_t>(data) >> 31) ZPP_MAYBE_UNLIKELY {
+            return maybe<maybe_view<type>>(wire_error::bad_format);
+        }
+        return maybe<maybe_view<type>>(maybe_view<type>(data));
+    }
+}
+} // namespace zpp
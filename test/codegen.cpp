@@ -0,0 +1,137 @@
+// Functions whose generated code is checked by codegen.sh, each line
+// starting with "// codegen:" names a function followed by its checks:
+//   like=<function> - calls the same functions as the given one, with at
+//                     most a quarter more instructions.
+//   no-stack        - does not spill to, or push onto, the stack, outside
+//                     of the code moved into the cold section.
+//   no-guard        - does not guard a static initialization.
+//   no-indirect     - makes no indirect calls or jumps, outside of the
+//                     code moved into the cold section.
+//   registers       - returns in registers, not through a hidden pointer.
+#include "maybe.h"
+
+namespace codegen
+{
+enum class error : int
+{
+    success = 0,
+    odd = 1,
+    negative = 2,
+};
+} // namespace codegen
+
+template <>
+inline constexpr auto zpp::define_error_category<codegen::error> =
+    zpp::make_error_category("codegen",
+                             codegen::error::success,
+                             {
+                                 {codegen::error::odd, "Odd."},
+                                 {codegen::error::negative, "Negative."},
+                             });
+
+zpp::maybe<int> parse(int value);
+zpp::maybe<int> half(int value);
+
+extern "C" {
+// codegen: return_value no-stack no-guard no-indirect registers
+zpp::maybe<int> return_value(int value)
+{
+    return value;
+}
+
+// codegen: return_error no-stack no-guard no-indirect registers
+zpp::maybe<int> return_error()
+{
+    return codegen::error::negative;
+}
+
+// codegen: propagate no-stack no-guard no-indirect registers
+zpp::maybe<int> propagate(int value)
+{
+    ZPP_TRY(auto parsed, parse(value));
+    return parsed * 2;
+}
+
+// codegen: is_success no-stack no-guard no-indirect registers
+bool is_success(zpp::error error)
+{
+    return bool(error);
+}
+
+// codegen: message_of no-guard
+std::string_view message_of(zpp::error error)
+{
+    return error.message();
+}
+
+// codegen: chain_monadic like=chain_hand no-stack no-guard no-indirect
+zpp::maybe<int> chain_monadic(int value)
+{
+    return parse(value).and_then(half).transform(
+        [](int result) { return result + 1; });
+}
+
+// codegen: chain_hand no-stack no-guard no-indirect
+zpp::maybe<int> chain_hand(int value)
+{
+    auto parsed = parse(value);
+    if (!parsed) {
+        return parsed.error();
+    }
+    auto halved = half(parsed.value());
+    if (!halved) {
+        return halved.error();
+    }
+    return halved.value() + 1;
+}
+
+// codegen: value_or_monadic like=value_or_hand no-stack no-indirect
+int value_or_monadic(int value)
+{
+    return parse(value).value_or(0);
+}
+
+// codegen: value_or_hand no-stack no-indirect
+int value_or_hand(int value)
+{
+    auto parsed = parse(value);
+    if (!parsed) {
+        return 0;
+    }
+    return parsed.value();
+}
+
+// codegen: or_else_monadic like=or_else_hand no-stack no-indirect
+zpp::maybe<int> or_else_monadic(int value)
+{
+    return parse(value).or_else(
+        [](const zpp::error &) { return zpp::maybe<int>(0); });
+}
+
+// codegen: or_else_hand no-stack no-indirect
+zpp::maybe<int> or_else_hand(int value)
+{
+    auto parsed = parse(value);
+    if (!parsed) {
+        return 0;
+    }
+    return parsed;
+}
+
+// codegen: transform_error_monadic like=transform_error_hand no-stack
+zpp::maybe<int> transform_error_monadic(int value)
+{
+    return parse(value).transform_error(
+        [](const zpp::error &) -> zpp::error { return codegen::error::odd; });
+}
+
+// codegen: transform_error_hand no-stack
+zpp::maybe<int> transform_error_hand(int value)
+{
+    auto parsed = parse(value);
+    if (!parsed) {
+        return codegen::error::odd;
+    }
+    return parsed;
+}
+}
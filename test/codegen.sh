@@ -0,0 +1,182 @@
+#!/bin/sh
+# Compiles codegen.cpp at -O2 with each available compiler, in both error
+# modes, and checks the generated x86-64 assembly of the functions listed
+# in it. Set CXX to a space separated list of compilers to override.
+set -u
+
+directory=$(cd "$(dirname "$0")" && pwd)
+compilers=${CXX:-"g++ clang++"}
+output=$(mktemp -d)
+trap 'rm -rf "$output"' EXIT
+failed=0
+checked=0
+
+# Prints the instructions of the given function, without labels and
+# directives. Given a third argument, stops at the code that the compiler
+# moved into the cold section, which is off the success path.
+body()
+{
+    awk -v name="$1" -v hot="${3-}" '
+        $0 == name ":" { inside = 1; next }
+        inside && $1 == ".size" { exit }
+        inside && hot != "" && $1 == ".section" && $2 ~ /unlikely/ { exit }
+        inside && $1 !~ /^\./ && $1 !~ /:$/ { print }
+    ' "$2"
+}
+
+# Prints the functions called by the given instructions, in order.
+calls()
+{
+    awk '$1 ~ /^(call|callq|jmp|jmpq)$/ && $2 !~ /^\./ { print $2 }'
+}
+
+# Prints the given instructions that use the return slot of a function
+# returning through memory: stores through the hidden pointer to it,
+# which the function receives in %rdi or copies to another register, and
+# the return of that pointer in %rax. Calls clobber the registers that
+# they do not preserve, and the instructions are followed in order.
+slot_uses()
+{
+    awk '
+        function register(operand)
+        {
+            gsub(/[[:space:]]/, "", operand)
+            if (operand ~ /^%e[a-z][a-z]$/) {
+                operand = "%r" substr(operand, 3)
+            } else if (operand ~ /^%r[0-9]+[dwb]$/) {
+                operand = substr(operand, 1, length(operand) - 1)
+            }
+            return operand
+        }
+        BEGIN { pointer["%rdi"] = 1 }
+        {
+            operands = $0
+            sub(/^[[:space:]]*[^[:space:]]+/, "", operands)
+        }
+        $1 ~ /^ret/ { if (pointer["%rax"]) print; next }
+        $1 ~ /^(call|callq)$/ {
+            split("rax rcx rdx rsi rdi r8 r9 r10 r11", clobbered, " ")
+            for (i in clobbered) {
+                delete pointer["%" clobbered[i]]
+            }
+            next
+        }
+        operands ~ /\)[[:space:]]*$/ {
+            base = operands
+            sub(/.*\(/, "", base)
+            sub(/[,)].*/, "", base)
+            if (pointer[base] && $1 !~ /^(cmp|test|bt|push)/) print
+            next
+        }
+        $1 ~ /^(j|push|cmp|test|bt)/ { next }
+        {
+            destination = operands
+            sub(/.*,/, "", destination)
+            destination = register(destination)
+            source = operands
+            sub(/,.*/, "", source)
+            gsub(/[[:space:]]/, "", source)
+            if ($1 ~ /^movq?$/ && operands ~ /,/ && pointer[source]) {
+                pointer[destination] = 1
+            } else {
+                delete pointer[destination]
+            }
+        }
+    '
+}
+
+fail()
+{
+    echo "FAIL $*"
+    failed=1
+}
+
+for compiler in $compilers; do
+    if ! command -v "$compiler" > /dev/null 2>&1; then
+        echo "SKIP $compiler: not found"
+        continue
+    fi
+    case $("$compiler" -dumpmachine) in
+    x86_64*) ;;
+    *)
+        echo "SKIP $compiler: the checks are for x86-64"
+        continue
+        ;;
+    esac
+
+    for compact in 0 1; do
+        assembly="$output/$(basename "$compiler")-$compact.s"
+        configuration="$compiler ZPP_MAYBE_COMPACT_ERROR=$compact"
+        if ! "$compiler" -std=c++17 -O2 -S -fno-asynchronous-unwind-tables \
+            -DZPP_MAYBE_COMPACT_ERROR=$compact -I"$directory/.." \
+            "$directory/codegen.cpp" -o "$assembly"; then
+            fail "$configuration: compilation"
+            continue
+        fi
+
+        grep '^// codegen:' "$directory/codegen.cpp" | tr -d '\r' |
+            while read -r _ _ function checks; do
+                instructions=$(body "$function" "$assembly")
+                hot=$(body "$function" "$assembly" hot)
+                if [ -z "$instructions" ]; then
+                    fail "$configuration: $function not found"
+                    continue
+                fi
+                for check in $checks; do
+                    case $check in
+                    like=*)
+                        other=$(body "${check#like=}" "$assembly")
+                        count=$(echo "$instructions" | wc -l)
+                        limit=$(echo "$other" | wc -l)
+                        limit=$((limit + limit / 4 + 1))
+                        [ "$count" -le "$limit" ] ||
+                            fail "$configuration: $function has" \
+                                "$count instructions, at most $limit" \
+                                "expected"
+                        [ "$(echo "$instructions" | calls)" = \
+                            "$(echo "$other" | calls)" ] ||
+                            fail "$configuration: $function calls" \
+                                "differ from ${check#like=}"
+                        ;;
+                    no-stack)
+                        echo "$hot" |
+                            grep -Eq '\(%[re]?(sp|bp)\)|push' &&
+                            fail "$configuration: $function uses the" \
+                                "stack"
+                        ;;
+                    no-guard)
+                        echo "$instructions" | grep -q '__cxa_guard' &&
+                            fail "$configuration: $function guards a" \
+                                "static initialization"
+                        ;;
+                    no-indirect)
+                        echo "$hot" |
+                            grep -Eq '(call|jmp)q?[[:space:]]+\*' &&
+                            fail "$configuration: $function makes an" \
+                                "indirect call"
+                        ;;
+                    registers)
+                        [ -n "$(echo "$hot" | slot_uses)" ] &&
+                            fail "$configuration: $function returns" \
+                                "through memory"
+                        ;;
+                    *)
+                        fail "$configuration: unknown check $check"
+                        ;;
+                    esac
+                done
+            done > "$output/result"
+        cat "$output/result"
+        grep -q '^FAIL' "$output/result" && failed=1
+        checked=1
+    done
+done
+
+if [ "$failed" != 0 ]; then
+    exit 1
+fi
+if [ "$checked" = 0 ]; then
+    echo "SKIP no compiler was checked"
+    exit 0
+fi
+echo "PASS"
@@ -0,0 +1,230 @@
+// Runs maybe tasks and checks that errors short circuit the awaiting
+// coroutines, and that tasks waiting for asynchronous events complete
+// through a callback, skipped before C++20.
+#include <cstdio>
+
+#if __cplusplus >= 202002L
+#include "test.h"
+#include "maybe_coroutine.h"
+#include <coroutine>
+#include <memory_resource>
+#include <string>
+#include <utility>
+
+namespace test
+{
+int steps = 0;
+
+zpp::maybe<int> parse(int value)
+{
+    if (value < 0) {
+        return error::negative;
+    }
+    return value;
+}
+
+zpp::maybe_task<int> add(int left, int right)
+{
+    auto first = co_await parse(left);
+    ++steps;
+    auto second = co_await parse(right);
+    ++steps;
+    co_return first + second;
+}
+
+zpp::maybe_task<std::string> print(int left, int right)
+{
+    auto sum = co_await add(left, right);
+    ++steps;
+    zpp::maybe<int> factor = 3;
+    auto & multiplier = co_await factor;
+    co_return std::to_string(sum * multiplier) + "!";
+}
+
+zpp::maybe_task<int> fail()
+{
+    co_return error::retry;
+}
+
+zpp::maybe_task<int> await_failure()
+{
+    auto value = co_await fail();
+    ++steps;
+    co_return value;
+}
+
+zpp::maybe_task<void> check(int value)
+{
+    co_await parse(value);
+    ++steps;
+}
+
+zpp::maybe_task<int> check_twice(int value)
+{
+    co_await check(value);
+    co_await check(value);
+    co_return value;
+}
+
+zpp::maybe_task<int> once()
+{
+    ++steps;
+    co_return 7;
+}
+
+zpp::maybe_task<int> await_twice(zpp::maybe_task<int> & task)
+{
+    auto first = co_await std::move(task);
+    auto second = co_await std::move(task);
+    co_return first + second;
+}
+
+/**
+ * An asynchronous event, which resumes the waiting coroutine once
+ * signaled.
+ */
+struct event
+{
+    struct awaiter
+    {
+        bool await_ready() const noexcept
+        {
+            return false;
+        }
+
+        void await_suspend(std::coroutine_handle<> handle) noexcept
+        {
+            awaited->waiting = handle;
+        }
+
+        void await_resume() const noexcept
+        {
+        }
+
+        event * awaited;
+    };
+
+    awaiter wait() noexcept
+    {
+        return {this};
+    }
+
+    void signal()
+    {
+        std::exchange(waiting, {}).resume();
+    }
+
+    std::coroutine_handle<> waiting;
+};
+
+zpp::maybe_task<int> receive(event & received, int value)
+{
+    co_await received.wait();
+    co_return co_await parse(value);
+}
+
+zpp::maybe_task<int> receive_twice(event & received, int value)
+{
+    auto first = co_await receive(received, value);
+    co_return first * 2;
+}
+} // namespace test
+
+int main()
+{
+    test::steps = 0;
+    auto printed = test::print(1, 2).run();
+    EXPECT(printed && printed.value() == "9!" && test::steps == 3);
+    test::steps = 0;
+    auto right = test::print(1, -2).run();
+    EXPECT(!right && right.error() == test::error::negative);
+    EXPECT(test::steps == 1);
+    test::steps = 0;
+    auto left = test::print(-1, 2).run();
+    EXPECT(!left && left.error().message() == "Negative.");
+    EXPECT(test::steps == 0);
+    auto failure = test::await_failure().run();
+    EXPECT(!failure && failure.error() == test::error::retry);
+    EXPECT(test::steps == 0);
+
+    // Void tasks.
+    auto checked = test::check_twice(1).run();
+    EXPECT(checked && checked.value() == 1 && test::steps == 2);
+    EXPECT(!test::check_twice(-1).run() && test::steps == 2);
+
+    // A completed task can be awaited again without resuming it.
+    test::steps = 0;
+    auto task = test::once();
+    EXPECT(std::move(task).run().value() == 7 && task.ready());
+    auto twice = test::await_twice(task).run();
+    EXPECT(twice && twice.value() == 14 && test::steps == 1);
+
+    // Moved from tasks result in an error.
+    auto moved = test::once();
+    auto target = std::move(moved);
+    EXPECT(std::move(moved).run().error() == zpp::coroutine_error::moved_from);
+    EXPECT(std::move(target).run().value() == 7);
+
+    // Tasks waiting for an asynchronous event do not complete in run,
+    // and complete through the callback of start.
+    test::event received;
+    auto suspended = test::receive(received, 4);
+    EXPECT(std::move(suspended).run().error() ==
+           zpp::coroutine_error::suspended);
+    received.signal();
+    EXPECT(std::move(suspended).run().value() == 4);
+    int completions = 0;
+    zpp::maybe<int> completed = test::error::failed;
+    auto on_complete = [&](zpp::maybe<int> & result) {
+        ++completions;
+        completed = std::move(result);
+    };
+    for (int value : {3, -3}) {
+        auto waiting = test::receive_twice(received, value);
+        waiting.start(on_complete);
+        EXPECT(completions == 0 && !waiting.ready());
+        received.signal();
+        EXPECT(completions == 1 && waiting.ready());
+        completions = 0;
+    }
+    EXPECT(!completed && completed.error() == test::error::negative);
+    auto started = test::add(2, 3);
+    started.start(on_complete);
+    EXPECT(completions == 1 && completed.value() == 5);
+    started.start(on_complete);
+    EXPECT(completions == 2);
+    auto frameless = std::move(started);
+    started.start(on_complete);
+    EXPECT(completed.error() == zpp::coroutine_error::moved_from);
+
+    // Frames from an arena and from a memory resource.
+    zpp::frame_arena<1024> arena;
+    {
+        zpp::frame_allocator_scope scope(arena);
+        auto pending = test::add(5, 1);
+        EXPECT(arena.used() > 0);
+        EXPECT(std::move(pending).run().value() == 6);
+    }
+    zpp::frame_arena<16> tiny;
+    {
+        zpp::frame_allocator_scope scope(tiny);
+        auto result = test::fail().run();
+        EXPECT(!result && result.error().message() ==
+                              "Failed to allocate the coroutine frame.");
+    }
+    char buffer[1024];
+    std::pmr::monotonic_buffer_resource resource(
+        buffer, sizeof(buffer), std::pmr::null_memory_resource());
+    {
+        zpp::frame_allocator_scope scope(resource);
+        EXPECT(test::add(3, 4).run().value() == 7);
+    }
+
+    return test::finish();
+}
+#else
+int main()
+{
+    std::puts("SKIP coroutines require C++20");
+}
+#endif
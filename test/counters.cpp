@@ -0,0 +1,81 @@
+// Counts failing errors per category and code, from several threads and
+// beyond the counter slots of a thread.
+#define ZPP_MAYBE_COUNTERS 1
+#define ZPP_MAYBE_COUNTER_SLOTS 4
+#include "test.h"
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+namespace test
+{
+zpp::maybe<int> parse(int value)
+{
+    if (value < 0) {
+        return error::failed;
+    }
+    if (value == 0) {
+        return error::retry;
+    }
+    return value;
+}
+
+std::uint64_t count(int code)
+{
+    zpp::error_count counts[16];
+    auto size = zpp::snapshot_error_counts(counts, 16);
+    std::uint64_t total = 0;
+    for (std::size_t index = 0; index != size; ++index) {
+        if (counts[index].code == code &&
+            counts[index].category == &zpp::category<error>()) {
+            total += counts[index].count;
+        }
+    }
+    return total;
+}
+} // namespace test
+
+int main()
+{
+    EXPECT(test::count(1) == 0);
+    for (int i = 0; i != 10; ++i) {
+        (void)test::parse(-1);
+    }
+    (void)test::parse(0);
+    (void)test::parse(3);
+    zpp::error success = test::error::success;
+    (void)success;
+
+    // Copies are not counted again.
+    auto failed = test::parse(-1);
+    auto copy = failed;
+    auto error = copy.error();
+    (void)error;
+    EXPECT(test::count(1) == 11 && test::count(2) == 1);
+    EXPECT(test::count(0) == 0);
+
+    std::vector<std::thread> threads;
+    for (int thread = 0; thread != 8; ++thread) {
+        threads.emplace_back([] {
+            for (int i = 0; i != 1000; ++i) {
+                (void)test::parse(-1);
+            }
+        });
+    }
+    for (auto & thread : threads) {
+        thread.join();
+    }
+    EXPECT(test::count(1) == 8011);
+
+    // A thread that fails with more codes than it has slots drops the
+    // counts of the codes that did not fit, its shard may be reused and
+    // hold the codes above already.
+    std::thread([] {
+        for (int code = 3; code != 10; ++code) {
+            zpp::error(test::error(code));
+        }
+    }).join();
+    EXPECT(zpp::dropped_error_counts() >= 3);
+
+    return test::finish();
+}
@@ -0,0 +1,288 @@
+// Checks error comparisons, error sets, error lists, payloads, the void
+// specialization of maybe, and replacing and relocating values by throwing
+// constructors.
+#include "test.h"
+#include <cstdint>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <unordered_set>
+
+namespace test
+{
+zpp::error check(int value)
+{
+    if (value % 3 == 0) {
+        return error::failed;
+    }
+    if (value % 5 == 0) {
+        return error::retry;
+    }
+    return error::success;
+}
+
+zpp::maybe_all<int, 4> validate(int count)
+{
+    zpp::error_list<4> errors;
+    for (int i = 1; i <= count; ++i) {
+        errors.push(check(i));
+    }
+    if (!errors) {
+        return errors;
+    }
+    return count;
+}
+
+zpp::maybe<int, std::uint32_t> parse(std::string_view text)
+{
+    if (text.empty()) {
+        return error::retry;
+    }
+    for (std::uint32_t i = 0; i != text.size(); ++i) {
+        if (text[i] < '0' || text[i] > '9') {
+            return zpp::basic_error<std::uint32_t>(error::failed, i);
+        }
+    }
+    return int(text.size());
+}
+
+zpp::maybe<int> twice(std::string_view text)
+{
+    ZPP_TRY(auto size, parse(text));
+    return size * 2;
+}
+
+/**
+ * A value whose constructor and move constructor both may throw.
+ */
+struct fragile
+{
+    explicit fragile(int initial) : text(std::to_string(initial))
+    {
+        if (initial < 0) {
+            throw std::invalid_argument("Negative.");
+        }
+    }
+
+    fragile(fragile && other) noexcept(false) : text(std::move(other.text))
+    {
+    }
+
+    std::string text;
+};
+
+/**
+ * Counts the live objects, and throws from the copy constructor once no
+ * copies are left. Its move constructor may throw, so it is copied when
+ * relocated.
+ */
+struct counted
+{
+    static inline int alive = 0;
+    static inline int copies = 0;
+
+    explicit counted(int initial) : value(initial)
+    {
+        ++alive;
+    }
+
+    counted(const counted & other) : value(other.value)
+    {
+        if (!copies--) {
+            throw std::length_error("No copies left.");
+        }
+        ++alive;
+    }
+
+    counted(counted && other) noexcept(false) : value(other.value)
+    {
+        ++alive;
+    }
+
+    ~counted()
+    {
+        --alive;
+    }
+
+    int value;
+};
+
+zpp::maybe<void> nonnegative(int value)
+{
+    if (value < 0) {
+        return error::negative;
+    }
+    return error::success;
+}
+
+#if __cplusplus >= 202002L
+constexpr std::size_t count_failures()
+{
+    zpp::error_list<2> errors;
+    errors.push(zpp::error(error::failed));
+    errors.push(zpp::error(error::success));
+    errors.push(zpp::maybe<int>(error::retry));
+    errors.push(zpp::error(error::negative));
+    return errors.size() * 10 + errors.overflow();
+}
+
+static_assert(count_failures() == 21);
+#endif
+
+#if __cplusplus >= 202002L && defined(__cpp_lib_constexpr_string)
+constexpr bool copy_strings()
+{
+    zpp::maybe<std::string> value(std::string("value"));
+    auto copy = value;
+    auto moved = std::move(copy);
+    copy = moved;
+    moved = std::move(copy);
+    zpp::maybe<std::string> failed = error::failed;
+    auto other = failed;
+    other = value;
+    failed = std::move(other);
+    value = zpp::maybe<std::string>(error::retry);
+    return moved.value() == "value" && failed.value() == "value" &&
+           value.error() == error::retry;
+}
+
+static_assert(copy_strings());
+#endif
+} // namespace test
+
+constexpr zpp::error_set<test::error> retryable{test::error::retry};
+static_assert(retryable.contains(test::error::retry));
+static_assert(!retryable.contains(test::error::failed));
+static_assert(!retryable.contains(test::error::negative));
+static_assert(std::is_trivially_copyable_v<zpp::error_list<4>>);
+static_assert(std::is_trivially_copyable_v<zpp::maybe<int, std::uint32_t>>);
+constexpr zpp::error constant = test::error::retry;
+static_assert(constant.is<test::error::retry>());
+static_assert(retryable.contains(constant));
+static_assert(bool(zpp::maybe<void>(test::error::success)));
+
+int main()
+{
+    // Comparisons and hashing.
+    zpp::error failed = test::error::failed;
+    zpp::error retry = test::error::retry;
+    EXPECT(failed == zpp::error(test::error::failed) && failed != retry);
+    EXPECT(failed == test::error::failed && test::error::failed == failed);
+    EXPECT(failed.is<test::error::failed>());
+    EXPECT(!retry.is<test::error::failed>());
+    EXPECT(retryable.contains(retry) && !retryable.contains(failed));
+    EXPECT(zpp::error(test::error::success) && !failed && !retry);
+    EXPECT(zpp::error(test::error::negative).code() == -3);
+    std::unordered_set<zpp::error> set{failed, retry};
+    EXPECT(set.count(zpp::error(test::error::retry)) == 1 && set.size() == 2);
+    // Duplicate codes of a table made at runtime do not make it dense.
+    const auto duplicates = zpp::make_error_category(
+        "duplicates",
+        test::error::success,
+        {{test::error::success, "Success."},
+         {test::error::success, "Again."},
+         {test::error::retry, "Retry."}});
+    EXPECT(duplicates.message(1) == "Unknown error occurred.");
+    EXPECT(duplicates.message(2) == "Retry.");
+    auto modified = retryable;
+    modified.insert(test::error::failed).erase(test::error::retry);
+    EXPECT(modified.contains(failed) && !modified.contains(retry));
+
+    // Lists keep the first errors and count the rest.
+    zpp::error_list<4> list;
+    EXPECT(list && list.empty());
+    for (int i = 1; i <= 20; ++i) {
+        list.push(test::check(i));
+    }
+    EXPECT(!list && list.size() == 4);
+    EXPECT(list.failures() == 9 && list.overflow() == 5);
+    int codes[] = {1, 2, 1, 1};
+    int index = 0;
+    for (auto & each : list) {
+        EXPECT(each.code() == codes[index++]);
+    }
+    list.clear();
+    list.push(zpp::maybe<int>(test::error::retry));
+    list.push(zpp::maybe<int>(1));
+    EXPECT(list.size() == 1 && list.front() == test::error::retry);
+    auto all = test::validate(2);
+    EXPECT(all && all.value() == 2 && all.errors().empty());
+    auto some = test::validate(10);
+    EXPECT(!some && some.error() == test::error::failed);
+    EXPECT(some.errors().size() == 4 && some.errors().failures() == 5);
+    zpp::maybe_all<std::string, 4> none = zpp::error_list<4>();
+    EXPECT(none && none.value().empty() && none.errors().empty());
+
+    // Payloads.
+    auto parsed = test::parse("12x4");
+    EXPECT(!parsed && parsed.error().payload() == 2);
+    EXPECT(parsed.error().message() == "Failed.");
+    EXPECT(test::parse("123").value() == 3);
+    EXPECT(test::twice("12").value() == 4);
+    EXPECT(test::twice("").error() == test::error::retry);
+    auto transformed = parsed.transform_error([](auto error) {
+        return zpp::basic_error<std::uint32_t>(error, error.payload() + 1);
+    });
+    EXPECT(transformed.error().payload() == 3);
+
+    // Void results, where success codes are success.
+    EXPECT(test::nonnegative(1) && !test::nonnegative(-1));
+    EXPECT(test::nonnegative(-1).error().code() == -3);
+    zpp::maybe<void, std::uint32_t> succeeded =
+        zpp::basic_error<std::uint32_t>(test::error::success, 7u);
+    EXPECT(bool(succeeded));
+    zpp::maybe<void, std::uint32_t> payload =
+        zpp::basic_error<std::uint32_t>(test::error::failed, 7u);
+    EXPECT(!payload && payload.error().payload() == 7u);
+
+#if defined(__cpp_exceptions)
+    // A throwing replace keeps a stored error, but loses a stored value.
+    zpp::maybe<test::fragile> fragile = test::error::retry;
+    for (int code : {-1, 1, -1}) {
+        try {
+            fragile.emplace(code);
+        } catch (const std::invalid_argument &) {
+        }
+    }
+    EXPECT(!fragile && fragile.error() == zpp::maybe_error::valueless);
+    EXPECT(fragile.error().message() ==
+           "The value was lost by a throwing replace.");
+    zpp::maybe<test::fragile> kept = test::error::retry;
+    try {
+        kept.emplace(-1);
+    } catch (const std::invalid_argument &) {
+    }
+    EXPECT(!kept && kept.error() == test::error::retry);
+    EXPECT(fragile.emplace(2).text == "2" && fragile);
+
+    // A throwing relocation destroys what it constructed and keeps the
+    // sources.
+    alignas(test::counted) unsigned char source[3 * sizeof(test::counted)];
+    alignas(test::counted) unsigned char target[3 * sizeof(test::counted)];
+    auto first = reinterpret_cast<test::counted *>(source);
+    auto destination = reinterpret_cast<test::counted *>(target);
+    for (int i = 0; i != 3; ++i) {
+        ::new (static_cast<void *>(first + i)) test::counted(i);
+    }
+    test::counted::copies = 1;
+    bool thrown = false;
+    try {
+        zpp::relocate(first, first + 3, destination);
+    } catch (const std::length_error &) {
+        thrown = true;
+    }
+    EXPECT(thrown && test::counted::alive == 3 && first[2].value == 2);
+    test::counted::copies = 3;
+    auto last = zpp::relocate(first, first + 3, destination);
+    EXPECT(last == destination + 3 && test::counted::alive == 3);
+    EXPECT(std::launder(destination)[2].value == 2);
+    for (auto each = std::launder(destination); each != last; ++each) {
+        each->~counted();
+    }
+    EXPECT(test::counted::alive == 0);
+#endif
+
+    return test::finish();
+}
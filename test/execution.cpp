@@ -0,0 +1,136 @@
+// Runs the sender adaptors of maybe_execution.h against stdexec, skipped
+// before C++20 and where <stdexec/execution.hpp> is not found on the
+// include path.
+#include <cstdio>
+
+#if __cplusplus >= 202002L && defined(__has_include)
+#if __has_include(<stdexec/execution.hpp>)
+#include <stdexec/execution.hpp>
+#define ZPP_MAYBE_EXECUTION_NAMESPACE stdexec
+#endif
+#endif
+
+#if defined(ZPP_MAYBE_EXECUTION_NAMESPACE)
+#include "maybe_execution.h"
+#include <optional>
+#include <stdexcept>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+namespace test
+{
+enum class error : int
+{
+    success = 0,
+    failed = 1,
+};
+} // namespace test
+
+template <>
+inline constexpr auto zpp::define_error_category<test::error> =
+    zpp::make_error_category("test",
+                             test::error::success,
+                             {
+                                 {test::error::failed, "Failed."},
+                             });
+
+namespace
+{
+int failures = 0;
+
+void expect(bool condition, const char * description)
+{
+    if (!condition) {
+        std::printf("FAIL %s\n", description);
+        ++failures;
+    }
+}
+
+/**
+ * Maps the value or error of an unwrapped sender to an int, so that it
+ * can be waited on.
+ */
+template <typename Sender>
+int wait_unwrapped(Sender && sender)
+{
+    auto result = stdexec::sync_wait(
+        std::forward<Sender>(sender) |
+        stdexec::upon_error(
+            [](const zpp::error & error) noexcept { return -error.code(); }));
+    return result ? std::get<0>(*result) : 0;
+}
+
+/**
+ * A value that throws when it is moved into a maybe.
+ */
+struct throwing
+{
+    throwing() = default;
+    throwing(throwing &&)
+    {
+        throw std::runtime_error("moved");
+    }
+};
+} // namespace
+
+int main()
+{
+    auto increment = stdexec::then([](int value) noexcept {
+        return value + 1;
+    });
+
+    expect(wait_unwrapped(stdexec::just(zpp::maybe<int>(1337)) |
+                          zpp::unwrap_maybe | increment) == 1338,
+           "unwrap_maybe sends the value");
+
+    auto failed = zpp::maybe<int>(test::error::failed);
+    expect(wait_unwrapped(stdexec::just(failed) | zpp::unwrap_maybe |
+                          increment) == -1,
+           "unwrap_maybe sends the error");
+
+    expect(wait_unwrapped(stdexec::just(zpp::maybe<void>()) |
+                          zpp::unwrap_maybe |
+                          stdexec::then([]() noexcept { return 1; })) == 1,
+           "unwrap_maybe of void sends no value");
+
+    auto value = stdexec::sync_wait(zpp::as_maybe(stdexec::just(1337)));
+    static_assert(std::is_same_v<decltype(value),
+                                 std::optional<std::tuple<zpp::maybe<int>>>>);
+    expect(value && std::get<0>(*value) &&
+               std::get<0>(*value).value() == 1337,
+           "as_maybe sends a maybe of the value");
+
+    auto error = stdexec::sync_wait(stdexec::just(failed) |
+                                    zpp::unwrap_maybe | zpp::as_maybe);
+    expect(error && !std::get<0>(*error) &&
+               std::get<0>(*error).error() == test::error::failed,
+           "as_maybe sends a maybe of the error");
+
+    auto success = stdexec::sync_wait(stdexec::just() | zpp::as_maybe);
+    static_assert(std::is_same_v<decltype(success),
+                                 std::optional<std::tuple<zpp::maybe<void>>>>);
+    expect(success && std::get<0>(*success),
+           "as_maybe of no value sends a maybe of void");
+
+    bool thrown = false;
+    try {
+        stdexec::sync_wait(stdexec::just() |
+                           stdexec::then([] { return throwing{}; }) |
+                           zpp::as_maybe);
+    } catch (const std::runtime_error &) {
+        thrown = true;
+    }
+    expect(thrown, "as_maybe sends the exception of constructing a maybe");
+
+    if (failures) {
+        return 1;
+    }
+    std::puts("PASS");
+}
+#else
+int main()
+{
+    std::puts("SKIP stdexec is not available");
+}
+#endif
@@ -0,0 +1,75 @@
+// Formats errors and maybe objects with std::format, skipped where the
+// standard library does not provide it.
+#include "maybe_format.h"
+#include <cstdio>
+
+#if defined(__cpp_lib_format)
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+namespace test
+{
+enum class error : int
+{
+    success = 0,
+    failed = 1,
+};
+} // namespace test
+
+template <>
+inline constexpr auto zpp::define_error_category<test::error> =
+    zpp::make_error_category("test",
+                             test::error::success,
+                             {
+                                 {test::error::failed, "Failed."},
+                             });
+
+namespace
+{
+int failures = 0;
+
+void expect(std::string_view formatted, std::string_view expected)
+{
+    if (formatted != expected) {
+        std::printf("FAIL \"%.*s\", expected \"%.*s\"\n",
+                    int(formatted.size()),
+                    formatted.data(),
+                    int(expected.size()),
+                    expected.data());
+        ++failures;
+    }
+}
+} // namespace
+
+int main()
+{
+    zpp::error failed = test::error::failed;
+    expect(std::format("{}", failed), "test:1: Failed.");
+    expect(std::format("[{}]", zpp::basic_error<std::uint32_t>(failed, 7)),
+           "[test:1: Failed.]");
+
+    expect(std::format("{:>5}", zpp::maybe<int>(42)), "   42");
+    expect(std::format("{:>5}", zpp::maybe<int>(failed)), "test:1: Failed.");
+    expect(std::format("{}", zpp::maybe<std::string>(std::string("value"))),
+           "value");
+    expect(std::format("{}", zpp::maybe<void>()), "success");
+    expect(std::format("{}", zpp::maybe<void>(failed)), "test:1: Failed.");
+
+    char buffer[7];
+    auto result = std::format_to_n(buffer, sizeof(buffer), "{}", failed);
+    expect(std::string_view(buffer, std::size_t(result.out - buffer)),
+           "test:1:");
+    expect(std::to_string(result.size), "15");
+
+    if (failures) {
+        return 1;
+    }
+    std::puts("PASS");
+}
+#else
+int main()
+{
+    std::puts("SKIP std::format is not available");
+}
+#endif
@@ -0,0 +1,242 @@
+// Transforms inputs in parallel and checks the collected values, the
+// reported errors in both error orders, exceptions of the workers, and
+// workers run inline or by an executor.
+#include "test.h"
+#include "maybe_parallel.h"
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <numeric>
+#include <stdexcept>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace test
+{
+struct number
+{
+    explicit number(int initial) : value(initial)
+    {
+    }
+
+    int value;
+};
+
+/**
+ * A thread pool that runs submitted tasks in order, and fails to submit
+ * once the given number of tasks was submitted.
+ */
+class pool final : public zpp::parallel_executor
+{
+public:
+    pool(unsigned threads, std::size_t capacity) : m_capacity(capacity)
+    {
+        for (unsigned i = 0; i != threads; ++i) {
+            m_threads.emplace_back([this] { serve(); });
+        }
+    }
+
+    ~pool()
+    {
+        {
+            std::lock_guard lock(m_mutex);
+            m_stopping = true;
+        }
+        m_ready.notify_all();
+        for (auto & thread : m_threads) {
+            thread.join();
+        }
+    }
+
+    void execute(void (*task)(void *) noexcept, void * context) override
+    {
+        {
+            std::lock_guard lock(m_mutex);
+            if (m_submitted == m_capacity) {
+#if defined(__cpp_exceptions)
+                throw std::runtime_error("full");
+#endif
+            }
+            ++m_submitted;
+            m_tasks.emplace_back(task, context);
+        }
+        m_ready.notify_one();
+    }
+
+    std::size_t submitted()
+    {
+        std::lock_guard lock(m_mutex);
+        return m_submitted;
+    }
+
+private:
+    void serve()
+    {
+        std::unique_lock lock(m_mutex);
+        while (true) {
+            m_ready.wait(lock, [&] { return m_stopping || !m_tasks.empty(); });
+            if (m_tasks.empty()) {
+                return;
+            }
+            auto [task, context] = m_tasks.front();
+            m_tasks.pop_front();
+            lock.unlock();
+            task(context);
+            lock.lock();
+        }
+    }
+
+    std::mutex m_mutex;
+    std::condition_variable m_ready;
+    std::deque<std::pair<void (*)(void *) noexcept, void *>> m_tasks;
+    std::vector<std::thread> m_threads;
+    std::size_t m_capacity;
+    std::size_t m_submitted = 0;
+    bool m_stopping = false;
+};
+} // namespace test
+
+int main()
+{
+    std::vector<int> input(100000);
+    std::iota(input.begin(), input.end(), 0);
+    auto twice = [](int value) -> zpp::maybe<long> { return long(value) * 2; };
+
+    // Values are collected in order.
+    for (auto policy : {zpp::parallel,
+                        zpp::parallel_policy{1, 3},
+                        zpp::parallel_policy{8, 1}}) {
+        auto result = zpp::parallel_transform_collect(policy, input, twice);
+        EXPECT(result && result.value().size() == input.size());
+        bool ordered = true;
+        for (std::size_t i = 0; i != input.size(); ++i) {
+            ordered = ordered && result.value()[i] == long(i) * 2;
+        }
+        EXPECT(ordered);
+    }
+    std::vector<int> empty;
+    auto none = zpp::parallel_transform_collect(zpp::parallel, empty, twice);
+    EXPECT(none && none.value().empty());
+    auto odd = zpp::parallel_transform_collect(
+        zpp::parallel_policy{8, 1}, input, [](int value) {
+            return zpp::maybe<bool>(value % 2 == 1);
+        });
+    static_assert(
+        std::is_same_v<decltype(odd.value()), std::vector<bool> &>);
+    EXPECT(odd && odd.value()[1] && !odd.value()[99998]);
+
+    // Deterministic runs report the error of the lowest index, others any.
+    auto fail = [](int value) -> zpp::maybe<int> {
+        if (value == 70000) {
+            return test::error::retry;
+        }
+        if (value == 500 || value == 99999) {
+            return test::error::failed;
+        }
+        return value;
+    };
+    for (int run = 0; run != 50; ++run) {
+        auto first = zpp::parallel_transform_collect(
+            zpp::parallel_policy{8, 16, true}, input, fail);
+        EXPECT(!first && first.error() == test::error::failed);
+        auto deterministic = zpp::parallel_transform_collect(
+            zpp::parallel_deterministic, input, fail);
+        EXPECT(!deterministic &&
+               deterministic.error() == test::error::failed);
+        auto any = zpp::parallel_transform_collect(
+            zpp::parallel_policy{8, 16}, input, fail);
+        EXPECT(!any && (any.error() == test::error::failed ||
+                        any.error() == test::error::retry));
+    }
+
+    // Output iterators, payloads and types that are not default
+    // constructible.
+    std::vector<test::number> output(1000, test::number(-1));
+    auto written = zpp::parallel_transform_collect(
+        zpp::parallel,
+        std::vector<int>(input.begin(), input.begin() + 1000),
+        output.begin(),
+        [](int value) { return zpp::maybe<test::number>(value + 1); });
+    EXPECT(written && written.value() == output.end());
+    EXPECT(output[999].value == 1000);
+    auto payload = zpp::parallel_transform_collect(
+        zpp::parallel, input, [](int value) -> zpp::maybe<int, int> {
+            if (value == 3) {
+                return zpp::basic_error<int>(test::error::failed, 77);
+            }
+            return value;
+        });
+    static_assert(std::is_same_v<decltype(payload),
+                                 zpp::maybe<std::vector<int>, int>>);
+    EXPECT(!payload && payload.error().payload() == 77);
+
+    // A single thread or chunk runs inline on the calling thread.
+    for (auto policy : {zpp::parallel_policy{1}, zpp::parallel_policy{8, 0}}) {
+        auto caller = std::this_thread::get_id();
+        bool inline_only = true;
+        auto result = zpp::parallel_transform_collect(
+            policy, std::vector<int>{1}, [&](int value) {
+                inline_only = std::this_thread::get_id() == caller;
+                return zpp::maybe<int>(value);
+            });
+        EXPECT(result && result.value()[0] == 1 && inline_only);
+    }
+
+    // Workers run by an executor, which the calling thread waits for.
+    {
+        test::pool pool(3, 1000);
+        zpp::parallel_policy policy{4, 16};
+        policy.executor = &pool;
+        for (int run = 0; run != 20; ++run) {
+            auto result =
+                zpp::parallel_transform_collect(policy, input, twice);
+            EXPECT(result && result.value()[99999] == 199998);
+            auto failure =
+                zpp::parallel_transform_collect(policy, input, fail);
+            EXPECT(!failure);
+        }
+        EXPECT(pool.submitted() == 120);
+    }
+
+#if defined(__cpp_exceptions)
+    // An executor failing to submit stops the submitted workers, and its
+    // exception is rethrown once they finish.
+    {
+        test::pool pool(2, 1);
+        zpp::parallel_policy policy{4, 16};
+        policy.executor = &pool;
+        bool caught = false;
+        try {
+            zpp::parallel_transform_collect(policy, input, twice);
+        } catch (const std::runtime_error &) {
+            caught = true;
+        }
+        EXPECT(caught && pool.submitted() == 1);
+    }
+
+    // Exceptions are rethrown after all workers stopped.
+    for (bool deterministic : {false, true}) {
+        for (int run = 0; run != 20; ++run) {
+            bool caught = false;
+            try {
+                zpp::parallel_transform_collect(
+                    zpp::parallel_policy{8, 16, deterministic},
+                    input,
+                    [](int value) -> zpp::maybe<int> {
+                        if (value == 5000) {
+                            throw std::runtime_error("failed");
+                        }
+                        return value;
+                    });
+            } catch (const std::runtime_error &) {
+                caught = true;
+            }
+            EXPECT(caught);
+        }
+    }
+#endif
+
+    return test::finish();
+}
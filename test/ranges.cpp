@@ -0,0 +1,86 @@
+// Iterates the values and errors of ranges of maybe objects and collects
+// them, skipped before C++20.
+#include <cstdio>
+
+#if __cplusplus >= 202002L
+#include "test.h"
+#include "maybe_ranges.h"
+#include <list>
+#include <memory>
+#include <ranges>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+int main()
+{
+    std::vector<zpp::maybe<std::string>> strings;
+    strings.emplace_back(std::string(40, 'a'));
+    strings.emplace_back(test::error::failed);
+    strings.emplace_back(std::string(40, 'b'));
+    static_assert(std::ranges::view<decltype(strings | zpp::views::values)>);
+
+    int values = 0;
+    for (auto & value : strings | zpp::views::values) {
+        static_assert(std::is_same_v<decltype(value), std::string &>);
+        value += "!";
+        ++values;
+    }
+    EXPECT(values == 2 && strings[2].value().back() == '!');
+    int errors = 0;
+    for (auto error : strings | zpp::views::errors) {
+        EXPECT(error == test::error::failed);
+        ++errors;
+    }
+    EXPECT(errors == 1);
+    auto collected = zpp::collect(strings);
+    EXPECT(!collected && collected.error() == test::error::failed);
+
+    // Moves out of rvalue ranges.
+    std::vector<zpp::maybe<std::unique_ptr<int>>> pointers;
+    pointers.emplace_back(std::make_unique<int>(1));
+    pointers.emplace_back(std::make_unique<int>(2));
+    auto moved = zpp::collect(std::move(pointers));
+    EXPECT(moved && moved.value().size() == 2 && *moved.value()[1] == 2);
+
+    // Other ranges, and the pipe.
+    std::list<zpp::maybe<int>> list{1, 2, 3};
+    auto piped = list | zpp::collect;
+    EXPECT(piped && piped.value().size() == 3 && piped.value()[2] == 3);
+    auto generated =
+        std::views::iota(0, 5) |
+        std::views::transform([](int i) { return zpp::maybe<int>(i); });
+    EXPECT(zpp::collect(generated).value().size() == 5);
+    int sum = 0;
+    for (int value : generated | zpp::views::values) {
+        sum += value;
+    }
+    EXPECT(sum == 10);
+    std::vector<zpp::maybe<int, int>> payloads{
+        zpp::basic_error<int>(test::error::retry, 5)};
+    auto payload = zpp::collect(payloads);
+    EXPECT(!payload && payload.error().payload() == 5);
+
+    // The pipe accepts the ranges that collect does, which need not be
+    // viewable.
+    const std::vector<zpp::maybe<int>> constant{4, 5};
+    auto from_constant = std::move(constant) | zpp::collect;
+    EXPECT(from_constant && from_constant.value()[1] == 5);
+
+    // Ranges of void maybe only report the first error.
+    std::vector<zpp::maybe<void>> checks(3);
+    auto checked = checks | zpp::collect;
+    static_assert(std::is_same_v<decltype(checked), zpp::maybe<void>>);
+    EXPECT(checked);
+    checks[1] = test::error::retry;
+    checks[2] = test::error::failed;
+    EXPECT(zpp::collect(checks).error() == test::error::retry);
+
+    return test::finish();
+}
+#else
+int main()
+{
+    std::puts("SKIP ranges require C++20");
+}
+#endif
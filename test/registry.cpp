@@ -0,0 +1,195 @@
+// Registers error categories, concurrently and until the registry is full,
+// and checks identifiers, lookups, identifier conflicts and error
+// comparisons.
+#define ZPP_MAYBE_MAX_ERROR_CATEGORIES 64
+#include "test.h"
+#include <atomic>
+#include <functional>
+#include <string>
+#include <thread>
+#include <unordered_set>
+#include <vector>
+
+namespace test
+{
+enum class first : int
+{
+    success = 0,
+    failed = 1,
+};
+
+enum class second : int
+{
+    success = 0,
+    failed = 1,
+};
+
+/**
+ * A category whose name is only known at runtime.
+ */
+class runtime_category final : public zpp::error_category
+{
+public:
+    runtime_category(std::string name, std::uint32_t id) :
+        zpp::error_category(0, id), m_name(std::move(name))
+    {
+    }
+
+    std::string_view name() const noexcept override
+    {
+        return m_name;
+    }
+
+    std::string_view message(int) const noexcept override
+    {
+        return "Runtime.";
+    }
+
+private:
+    std::string m_name;
+};
+
+/**
+ * A category without an explicit identifier, so that its identifier is
+ * the hash of its name.
+ */
+class legacy_category final : public zpp::error_category
+{
+public:
+    legacy_category() : zpp::error_category(0)
+    {
+    }
+
+    std::string_view name() const noexcept override
+    {
+        return "legacy";
+    }
+
+    std::string_view message(int) const noexcept override
+    {
+        return "Legacy.";
+    }
+};
+} // namespace test
+
+// Two categories that clash on an explicit identifier.
+template <>
+inline constexpr auto zpp::define_error_category<test::first> =
+    zpp::make_error_category("first",
+                             77,
+                             test::first::success,
+                             {{test::first::failed, "First."}});
+
+template <>
+inline constexpr auto zpp::define_error_category<test::second> =
+    zpp::make_error_category("second",
+                             77,
+                             test::second::success,
+                             {{test::second::failed, "Second."}});
+
+// A copy of the test category, as another shared object would have.
+constexpr auto copied_category =
+    zpp::make_error_category("test",
+                             test::error::success,
+                             {{test::error::failed, "Failed."}});
+
+static_assert(zpp::category<test::error>().id() ==
+              zpp::make_error_category_id("test"));
+static_assert(zpp::category<test::first>().id() == 77);
+static_assert(zpp::make_error_category_id("test") < (1u << 31));
+
+int main()
+{
+    auto & category = zpp::category<test::error>();
+    zpp::error failed = test::error::failed;
+    EXPECT(failed.category_id() == category.id());
+    EXPECT(&failed.category() == &category);
+    EXPECT(zpp::register_error_category<test::error>());
+    EXPECT(zpp::find_error_category(category.id()) == &category);
+    EXPECT(zpp::find_error_category(12345) == nullptr);
+
+    // The copy maps to the registered category, and its errors compare
+    // equal to the errors of the original.
+    EXPECT(zpp::register_error_category(copied_category));
+    EXPECT(zpp::find_error_category(category.id()) == &category);
+    zpp::error copied(test::error::failed, copied_category);
+    EXPECT(copied == failed && copied.is<test::error::failed>());
+    EXPECT(std::hash<zpp::error>{}(copied) == std::hash<zpp::error>{}(failed));
+
+    // Identifiers hashed from the name, by two instances of a category.
+    test::legacy_category legacy;
+    test::legacy_category other_legacy;
+    EXPECT(legacy.id() == zpp::make_error_category_id("legacy"));
+    EXPECT(legacy.id() == zpp::make_error_category_id("legacy"));
+    EXPECT(zpp::error(test::error::failed, legacy) ==
+           zpp::error(test::error::failed, other_legacy));
+
+    // A clash poisons the identifier, neither category is found by it
+    // anymore. In compact mode both categories were registered on
+    // startup, when the identifiers of their errors were initialized.
+#if !ZPP_MAYBE_COMPACT_ERROR
+    EXPECT(zpp::register_error_category<test::first>());
+    EXPECT(zpp::find_error_category(77) == &zpp::category<test::first>());
+#endif
+    EXPECT(!zpp::register_error_category<test::second>());
+    EXPECT(zpp::find_error_category(77) == nullptr);
+    EXPECT(!zpp::register_error_category<test::first>());
+    zpp::error first = test::first::failed;
+    zpp::error second = test::second::failed;
+    EXPECT(first.category_id() == 77 && second.category_id() == 77);
+    EXPECT(first.is<test::first::failed>() && first == second);
+#if ZPP_MAYBE_COMPACT_ERROR
+    EXPECT(first.message() == "Error category is not registered.");
+#else
+    EXPECT(first.message() == "First." && second.message() == "Second.");
+#endif
+
+    // Threads race to register the same categories, and construct errors
+    // of a category registered on first use.
+    std::vector<test::runtime_category> racing;
+    for (std::uint32_t i = 0; i != 32; ++i) {
+        racing.emplace_back("racing " + std::to_string(i), 1000 + i);
+    }
+    std::atomic<int> raced{};
+    std::vector<std::thread> threads;
+    for (int thread = 0; thread != 8; ++thread) {
+        threads.emplace_back([&] {
+            for (auto & each : racing) {
+                raced += zpp::register_error_category(each) &&
+                         zpp::find_error_category(each.id()) == &each;
+            }
+            zpp::error error = test::error::retry;
+            raced += error.message() == "Retry.";
+        });
+    }
+    for (auto & thread : threads) {
+        thread.join();
+    }
+    EXPECT(raced == 8 * 33);
+    for (auto & each : racing) {
+        EXPECT(zpp::find_error_category(each.id()) == &each);
+    }
+
+    // Fill the registry, the categories that did not fit keep their
+    // identifiers so that their errors never compare equal.
+    std::vector<test::runtime_category> filling;
+    for (std::uint32_t i = 0; i != 64; ++i) {
+        filling.emplace_back("filling " + std::to_string(i), 2000 + i);
+    }
+    int registered = 0;
+    for (auto & each : filling) {
+        registered += zpp::register_error_category(each);
+    }
+    EXPECT(registered > 0 && registered < 64);
+    auto & unregistered = filling.back();
+    EXPECT(!zpp::register_error_category(unregistered));
+    EXPECT(zpp::find_error_category(unregistered.id()) == nullptr);
+    zpp::error full(test::error::failed, unregistered);
+    zpp::error other(test::error::failed, filling[filling.size() - 2]);
+    EXPECT(full.category_id() == unregistered.id());
+    EXPECT(full != other && full != failed);
+    std::unordered_set<zpp::error> errors{full, other, failed};
+    EXPECT(errors.size() == 3);
+
+    return test::finish();
+}
@@ -0,0 +1,63 @@
+#!/bin/sh
+# Builds and runs the test programs with each available compiler, in both
+# error modes, in C++17, C++20 and the newest standard the compiler
+# supports. Programs whose dependencies or standard are missing report
+# SKIP. Set CXX to a space separated list of compilers, and CXXFLAGS to add
+# flags, such as the include path of stdexec or sanitizers.
+set -u
+
+directory=$(cd "$(dirname "$0")" && pwd)
+compilers=${CXX:-"g++ clang++"}
+programs="errors registry wire counters sampling status system vector"
+programs="$programs parallel coroutine ranges execution format"
+output=$(mktemp -d)
+trap 'rm -rf "$output"' EXIT
+failed=0
+
+for compiler in $compilers; do
+    if ! command -v "$compiler" > /dev/null 2>&1; then
+        echo "SKIP $compiler: not found"
+        continue
+    fi
+
+    standards=
+    newest=
+    for candidate in c++17 c++20 c++26 c++2c c++23 c++2b; do
+        if echo 'int main(){}' |
+            "$compiler" -std=$candidate -x c++ - -o "$output/probe" \
+                > /dev/null 2>&1; then
+            case $candidate in
+            c++17 | c++20) standards="$standards $candidate" ;;
+            *) newest=$candidate && break ;;
+            esac
+        fi
+    done
+    standards="$standards $newest"
+    if [ -z "${standards# }" ]; then
+        echo "SKIP $compiler: C++17 is not supported"
+        continue
+    fi
+
+    for standard in $standards; do
+        for compact in 0 1; do
+            for program in $programs; do
+                configuration="$compiler -std=$standard"
+                configuration="$configuration ZPP_MAYBE_COMPACT_ERROR=$compact"
+                if ! "$compiler" -std=$standard -Wall -Wextra -pthread \
+                    -DZPP_MAYBE_COMPACT_ERROR=$compact ${CXXFLAGS-} \
+                    -I"$directory/.." "$directory/$program.cpp" \
+                    -o "$output/$program"; then
+                    echo "FAIL $configuration: $program compilation"
+                    failed=1
+                    continue
+                fi
+                result=$("$output/$program")
+                status=$?
+                echo "$configuration: $program: $result"
+                [ "$status" = 0 ] || failed=1
+            done
+        done
+    done
+done
+
+exit $failed
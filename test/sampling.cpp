@@ -0,0 +1,120 @@
+// Samples failing errors with their locations, at the default period, at
+// periods set per category, and across changes of the period.
+#define ZPP_MAYBE_COUNTERS 1
+#define ZPP_MAYBE_SAMPLING 1
+#define ZPP_MAYBE_SAMPLE_PERIOD 10
+#define ZPP_MAYBE_SAMPLE_CAPACITY 1024
+#include "test.h"
+#include "maybe_system.h"
+#include <cerrno>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+namespace test
+{
+enum class other : int
+{
+    success = 0,
+    failed = 1,
+};
+} // namespace test
+
+template <>
+inline constexpr auto zpp::define_error_category<test::other> =
+    zpp::make_error_category("other",
+                             test::other::success,
+                             {{test::other::failed, "Other."}});
+
+namespace test
+{
+constexpr int failed_line = __LINE__ + 4;
+zpp::maybe<int> parse(int value)
+{
+    if (value <= 0) {
+        return value ? error::failed : error::retry;
+    }
+    return value;
+}
+
+constexpr int other_line = __LINE__ + 3;
+zpp::maybe<void> fail()
+{
+    return other::failed;
+}
+
+zpp::error_sample samples[2048];
+
+std::size_t count(int line)
+{
+    auto size = zpp::snapshot_error_samples(samples, 2048);
+    std::size_t total = 0;
+    for (std::size_t index = 0; index != size; ++index) {
+        if (int(samples[index].line) == line) {
+            EXPECT(std::strstr(samples[index].file, "sampling.cpp"));
+            EXPECT(samples[index].frames == 0);
+            ++total;
+        }
+    }
+    return total;
+}
+} // namespace test
+
+int main()
+{
+    // The first error of each slot, and every tenth after it.
+    for (int i = 0; i != 30; ++i) {
+        (void)test::parse(-1);
+    }
+    EXPECT(test::count(test::failed_line) == 3);
+    for (int i = 0; i != 3; ++i) {
+        (void)test::parse(0);
+    }
+    EXPECT(test::count(test::failed_line) == 4);
+
+    // Periods set per category.
+    EXPECT(zpp::set_error_sample_period<test::other>(1));
+    for (int i = 0; i != 5; ++i) {
+        (void)test::fail();
+    }
+    EXPECT(test::count(test::other_line) == 5);
+    int errno_line = __LINE__ + 1;
+    auto invalid = zpp::from_errno(EINVAL);
+    (void)invalid;
+    EXPECT(test::count(errno_line) == 1);
+    EXPECT(zpp::set_error_sample_period<test::other>(0));
+    std::thread([] {
+        for (int i = 0; i != 5; ++i) {
+            (void)test::fail();
+        }
+    }).join();
+    EXPECT(test::count(test::other_line) == 5);
+
+    // Countdowns restart when the period changes, including after
+    // sampling was disabled.
+    for (int i = 0; i != 5; ++i) {
+        (void)test::fail();
+    }
+    EXPECT(test::count(test::other_line) == 5);
+    EXPECT(zpp::set_error_sample_period<test::other>(2));
+    for (int i = 0; i != 4; ++i) {
+        (void)test::fail();
+    }
+    EXPECT(test::count(test::other_line) == 7);
+
+    std::vector<std::thread> threads;
+    for (int thread = 0; thread != 8; ++thread) {
+        threads.emplace_back([] {
+            for (int i = 0; i != 1000; ++i) {
+                (void)test::parse(-1);
+            }
+        });
+    }
+    for (auto & thread : threads) {
+        thread.join();
+    }
+    auto sampled = test::count(test::failed_line);
+    EXPECT(sampled > 4 && sampled <= 4 + 8 * 100);
+
+    return test::finish();
+}
@@ -0,0 +1,66 @@
+// Reports errors through the thread local status of nested scopes.
+#include "test.h"
+#include "maybe_status.h"
+#include <cstdint>
+#include <thread>
+
+namespace test
+{
+std::uint8_t decode(std::uint8_t byte)
+{
+    if (byte > 127) {
+        zpp::fail(byte == 200 ? error::retry : error::failed);
+        return 0;
+    }
+    return byte;
+}
+
+zpp::maybe<int> parse(int value)
+{
+    if (value < 0) {
+        return error::negative;
+    }
+    return value;
+}
+} // namespace test
+
+int main()
+{
+    EXPECT(!zpp::failed());
+    {
+        zpp::status_scope scope;
+        int sum = 0;
+        for (std::uint8_t byte : {1, 2, 130, 200}) {
+            sum += test::decode(byte);
+        }
+        // The first error is kept.
+        EXPECT(scope.failed() && zpp::failed() && sum == 3);
+        EXPECT(scope.error() == test::error::failed);
+        auto result = scope.result(sum);
+        EXPECT(!result && result.error() == test::error::failed);
+
+        {
+            zpp::status_scope inner;
+            EXPECT(!zpp::failed());
+            // Success codes are not failures.
+            zpp::fail(test::error::success);
+            EXPECT(!zpp::failed() && !inner.failed());
+            zpp::fail(test::error::retry);
+            EXPECT(inner.error() == test::error::retry);
+        }
+        EXPECT(scope.error() == test::error::failed);
+
+        scope.clear();
+        EXPECT(!scope.failed() && scope.result(5).value() == 5);
+        EXPECT(zpp::value_or_fail(test::parse(3), 0) == 3 && !zpp::failed());
+        EXPECT(zpp::value_or_fail(test::parse(-1), 7) == 7);
+        EXPECT(scope.error() == test::error::negative);
+
+        bool other = true;
+        std::thread([&] { other = zpp::failed(); }).join();
+        EXPECT(!other);
+    }
+    EXPECT(!zpp::failed());
+
+    return test::finish();
+}
@@ -0,0 +1,143 @@
+// Converts between errors, errno values and std::error_code.
+#include "test.h"
+#include "maybe_system.h"
+#include <cerrno>
+#include <cstring>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace test
+{
+/**
+ * A standard category that maps one of its codes to a generic condition.
+ */
+class foreign_category final : public std::error_category
+{
+public:
+    const char * name() const noexcept override
+    {
+        return "foreign";
+    }
+
+    std::string message(int) const override
+    {
+        return "Foreign.";
+    }
+
+    std::error_condition default_error_condition(int code) const
+        noexcept override
+    {
+        if (code == 5) {
+            return std::error_condition(EPIPE, std::generic_category());
+        }
+        return std::error_condition(code, *this);
+    }
+};
+
+const foreign_category foreign;
+
+/**
+ * A category whose name is only known at runtime.
+ */
+class runtime_category final : public zpp::error_category
+{
+public:
+    runtime_category(std::string name, std::uint32_t id) :
+        zpp::error_category(0, id), m_name(std::move(name))
+    {
+    }
+
+    std::string_view name() const noexcept override
+    {
+        return m_name;
+    }
+
+    std::string_view message(int) const noexcept override
+    {
+        return "Runtime.";
+    }
+
+private:
+    std::string m_name;
+};
+} // namespace test
+
+int main()
+{
+    zpp::error again = std::errc::resource_unavailable_try_again;
+    EXPECT(!again && again.message() == "Resource temporarily unavailable");
+    errno = EINVAL;
+    auto invalid = zpp::from_errno();
+    EXPECT(invalid == std::errc::invalid_argument);
+    EXPECT(invalid.message() == "Invalid argument");
+    EXPECT(zpp::from_errno(0));
+    EXPECT(zpp::from_errno(0).message() == zpp::error::no_error);
+    EXPECT(zpp::from_errno(100000).message() == "Unknown error occurred.");
+    EXPECT(zpp::from_errno(-3).message() == "Unknown error occurred.");
+
+    // Generic and system codes in both directions.
+    auto code = zpp::to_error_code(again);
+    EXPECT(code == std::errc::resource_unavailable_try_again);
+    EXPECT(&code.category() == &std::generic_category());
+    EXPECT(zpp::from_error_code(code) == again);
+    zpp::error missing = zpp::system_error(ENOENT);
+    EXPECT(missing.message() == "No such file or directory");
+    std::error_code system = zpp::system_error(ENOENT);
+    EXPECT(&system.category() == &std::system_category());
+    EXPECT(system == std::errc::no_such_file_or_directory);
+    EXPECT(zpp::from_error_code(system) == missing);
+    EXPECT(zpp::to_error_code(missing) == system);
+
+    // Categories of this library are adapted and mapped back.
+    zpp::error failed = test::error::failed;
+    auto adapted = zpp::to_error_code(failed);
+    EXPECT(std::strcmp(adapted.category().name(), "test") == 0);
+    EXPECT(adapted.message() == "Failed." && adapted.value() == 1);
+    EXPECT(&zpp::to_error_code(failed).category() == &adapted.category());
+    auto back = zpp::from_error_code(adapted);
+    EXPECT(back == failed && back.message() == "Failed.");
+
+    // Threads race to convert errors of categories converted first, and
+    // all get the same adapter of each category.
+    std::vector<test::runtime_category> categories;
+    for (std::uint32_t i = 0; i != 16; ++i) {
+        categories.emplace_back("runtime " + std::to_string(i), 3000 + i);
+    }
+    std::vector<std::vector<std::error_code>> codes(8);
+    std::vector<std::thread> threads;
+    for (auto & converted : codes) {
+        threads.emplace_back([&] {
+            for (auto & category : categories) {
+                converted.push_back(zpp::to_error_code(
+                    zpp::error(test::error::failed, category)));
+            }
+        });
+    }
+    for (auto & thread : threads) {
+        thread.join();
+    }
+    bool same = true;
+    for (auto & converted : codes) {
+        for (std::size_t i = 0; i != categories.size(); ++i) {
+            same = same && converted[i] == codes[0][i] &&
+                   converted[i].category().name() ==
+                       "runtime " + std::to_string(i) &&
+                   zpp::from_error_code(converted[i]).category_id() ==
+                       categories[i].id();
+        }
+    }
+    EXPECT(same);
+
+    // Foreign categories map through their generic conditions.
+    EXPECT(zpp::from_error_code(std::error_code(5, test::foreign)) ==
+           std::errc::broken_pipe);
+    EXPECT(zpp::from_error_code(std::error_code(6, test::foreign)) ==
+           std::errc::io_error);
+    EXPECT(zpp::from_error_code(std::error_code(0, test::foreign)));
+    EXPECT(zpp::from_error_code(std::error_code()));
+
+    return test::finish();
+}
@@ -0,0 +1,60 @@
+#pragma once
+// Shared by the behavioral test programs: an expectation that reports the
+// failing expression and location without stopping the program, and the
+// error category the tests construct errors of.
+#include "maybe.h"
+#include <cstdio>
+
+namespace test
+{
+enum class error : int
+{
+    success = 0,
+    failed = 1,
+    retry = 2,
+    negative = -3,
+};
+
+/**
+ * The number of failed expectations.
+ */
+inline int failures = 0;
+
+/**
+ * Records a failed expectation.
+ */
+inline void expect(bool condition, const char * expression, int line)
+{
+    if (!condition) {
+        std::printf("FAIL line %d: %s\n", line, expression);
+        ++failures;
+    }
+}
+
+/**
+ * Prints the result of the program, and returns its exit status.
+ */
+inline int finish()
+{
+    if (failures) {
+        return 1;
+    }
+    std::puts("PASS");
+    return 0;
+}
+} // namespace test
+
+template <>
+inline constexpr auto zpp::define_error_category<test::error> =
+    zpp::make_error_category("test",
+                             test::error::success,
+                             {
+                                 {test::error::failed, "Failed."},
+                                 {test::error::retry, "Retry."},
+                                 {test::error::negative, "Negative."},
+                             });
+
+/**
+ * Expects the given condition to hold.
+ */
+#define EXPECT(...) ::test::expect(bool(__VA_ARGS__), #__VA_ARGS__, __LINE__)
@@ -0,0 +1,117 @@
+// Stores maybe objects in the split value and error layout, including
+// construction that throws midway.
+#include "test.h"
+#include "maybe_vector.h"
+#include <stdexcept>
+#include <string>
+
+namespace test
+{
+zpp::maybe<int> parse(int value)
+{
+    if (value % 7 == 0) {
+        return error::failed;
+    }
+    return value;
+}
+
+/**
+ * Throws from its constructors once the budget is spent.
+ */
+struct fragile
+{
+    static inline int budget = 1 << 30;
+
+    fragile()
+    {
+        spend();
+    }
+
+    fragile(int initial) : value(initial)
+    {
+        spend();
+    }
+
+    fragile(const fragile &) noexcept = default;
+    fragile(fragile &&) noexcept = default;
+    fragile & operator=(const fragile &) = default;
+
+    static void spend()
+    {
+        if (!budget--) {
+            throw std::runtime_error("Out of budget.");
+        }
+    }
+
+    int value = 0;
+};
+} // namespace test
+
+int main()
+{
+    zpp::maybe_vector<int> numbers;
+    EXPECT(numbers.all_ok() && numbers.count_errors() == 0);
+    for (int i = 1; i <= 300; ++i) {
+        numbers.push_back(test::parse(i));
+    }
+    EXPECT(numbers.size() == 300 && numbers.count_errors() == 42);
+    EXPECT(!numbers.all_ok() && numbers.span().count_errors() == 42);
+    bool consistent = true;
+    for (int i = 1; i <= 300; ++i) {
+        auto each = numbers.get(i - 1);
+        consistent = consistent && numbers.ok(i - 1) == (i % 7 != 0) &&
+                     bool(each) == (i % 7 != 0) &&
+                     (each ? each.value() == i
+                           : each.error() == test::error::failed);
+    }
+    EXPECT(consistent);
+    std::size_t values = 0;
+    numbers.for_each_value([&](std::size_t index, int value) {
+        EXPECT(int(index) + 1 == value);
+        ++values;
+    });
+    EXPECT(values == 258);
+    for (auto & [index, error] : numbers.errors()) {
+        EXPECT((index + 1) % 7 == 0 && !error);
+    }
+
+    zpp::maybe_vector<std::string> strings;
+    for (int i = 0; i != 64; ++i) {
+        strings.push_back(std::to_string(i));
+    }
+    EXPECT(strings.span().all_ok());
+    strings.push_back(zpp::error(test::error::retry));
+    EXPECT(!strings.span().all_ok() && strings.span().count_errors() == 1);
+    zpp::maybe_span<const std::string> span = strings;
+    EXPECT(span.get(3).value() == "3" && !span.get(64));
+    EXPECT(span.error(64) == test::error::retry);
+    // Elements holding values, and spans without errors, have no error.
+    EXPECT(span.error(3) && span.error(3) == zpp::maybe_error::success);
+    EXPECT(zpp::maybe_vector<int>().span().error(0));
+    EXPECT(numbers.error(5) && numbers.error(6) == test::error::failed);
+
+#if defined(__cpp_exceptions)
+    // A throwing constructor leaves the elements pushed before it.
+    for (int budget = 0; budget != 200; ++budget) {
+        zpp::maybe_vector<test::fragile> fragile;
+        test::fragile::budget = budget;
+        int pushed = 0;
+        try {
+            for (int i = 0; i != 150; ++i) {
+                if (i % 3) {
+                    fragile.emplace_back(i);
+                } else {
+                    fragile.push_back(zpp::error(test::error::failed));
+                }
+                ++pushed;
+            }
+        } catch (const std::runtime_error &) {
+        }
+        test::fragile::budget = 1 << 30;
+        EXPECT(int(fragile.size()) == pushed);
+        EXPECT(fragile.count_errors() == std::size_t((pushed + 2) / 3));
+    }
+#endif
+
+    return test::finish();
+}
@@ -0,0 +1,102 @@
+// Encodes errors and maybe objects into the wire format and decodes them
+// back, including buffers that are rejected.
+#include "test.h"
+#include "maybe_wire.h"
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+namespace test
+{
+struct point
+{
+    int x;
+    float y;
+};
+
+struct reading
+{
+    explicit reading(int initial) : value(initial)
+    {
+    }
+
+    int value;
+};
+} // namespace test
+
+int main()
+{
+    zpp::register_error_category<test::error>();
+
+    // Values, in little endian order.
+    unsigned char buffer[zpp::maybe_wire_size<std::uint32_t>];
+    auto written =
+        zpp::serialize_into(buffer, zpp::maybe<std::uint32_t>(0x11223344u));
+    EXPECT(written && written.value() == zpp::maybe_wire_size<std::uint32_t>);
+    EXPECT(buffer[0] == 0 && buffer[12] == 4);
+    EXPECT(buffer[16] == 0x44 && buffer[19] == 0x11);
+    auto value = zpp::view_from<zpp::maybe<std::uint32_t>>(buffer);
+    EXPECT(value && value.value() && value.value().value() == 0x11223344u);
+    EXPECT(value.value().get().value() == 0x11223344u);
+
+    // Errors of a maybe, the payload bytes are zero.
+    EXPECT(zpp::serialize_into(
+        buffer, zpp::maybe<std::uint32_t>(test::error::negative)));
+    auto failed = zpp::view_from<zpp::maybe<std::uint32_t>>(buffer).value();
+    EXPECT(!failed && !failed.get());
+    EXPECT(failed.error() == test::error::negative);
+    EXPECT(failed.error().message() == "Negative.");
+    EXPECT(buffer[16] == 0 && buffer[19] == 0);
+
+    // Plain errors, including success codes.
+    std::vector<char> encoded(zpp::error_wire_size);
+    EXPECT(zpp::serialize_into(encoded, zpp::error(test::error::retry)));
+    auto error = zpp::view_from<zpp::error>(encoded).value();
+    EXPECT(!error && error.code() == 2);
+    EXPECT(error.category_id() == zpp::make_error_category_id("test"));
+    EXPECT(error.error() == test::error::retry);
+    EXPECT(&error.error().category() == &zpp::category<test::error>());
+    EXPECT(zpp::serialize_into(encoded, zpp::error(test::error::success)));
+    EXPECT(bool(zpp::view_from<zpp::error>(encoded).value()));
+    EXPECT(bool(zpp::view_from<zpp::error>(encoded).value().error()));
+
+    // Other trivially copyable values.
+    unsigned char point[zpp::maybe_wire_size<test::point>];
+    zpp::serialize_into(point, zpp::maybe<test::point>(test::point{3, 1.5f}));
+    auto decoded = zpp::view_from<zpp::maybe<test::point>>(point);
+    EXPECT(decoded.value().value().x == 3);
+    EXPECT(decoded.value().value().y == 1.5f);
+    unsigned char real[zpp::maybe_wire_size<double>];
+    zpp::serialize_into(real, zpp::maybe<double>(2.25));
+    EXPECT(zpp::view_from<zpp::maybe<double>>(real).value().value() == 2.25);
+    unsigned char reading[zpp::maybe_wire_size<test::reading>];
+    zpp::serialize_into(reading, zpp::maybe<test::reading>(test::reading(9)));
+    auto sensor = zpp::view_from<zpp::maybe<test::reading>>(reading);
+    EXPECT(sensor.value().get().value().value == 9);
+
+    // Rejected buffers.
+    std::array<std::byte, 8> small{};
+    auto too_small =
+        zpp::serialize_into(small, zpp::error(test::error::failed));
+    EXPECT(!too_small &&
+           too_small.error() == zpp::wire_error::buffer_too_small);
+    EXPECT(zpp::view_from<zpp::error>(small).error() ==
+           zpp::wire_error::buffer_too_small);
+    EXPECT(zpp::view_from<zpp::maybe<std::uint64_t>>(buffer).error() ==
+           zpp::wire_error::buffer_too_small);
+    EXPECT(zpp::view_from<zpp::maybe<std::uint16_t>>(buffer).error() ==
+           zpp::wire_error::size_mismatch);
+    std::memset(encoded.data(), 0, encoded.size());
+    EXPECT(zpp::view_from<zpp::error>(encoded).error() ==
+           zpp::wire_error::bad_format);
+    encoded[3] = char(0x80);
+    EXPECT(zpp::view_from<zpp::error>(encoded).error() ==
+           zpp::wire_error::bad_format);
+    reading[3] = 0x80;
+    EXPECT(zpp::view_from<zpp::maybe<test::reading>>(reading).error() ==
+           zpp::wire_error::bad_format);
+
+    return test::finish();
+}